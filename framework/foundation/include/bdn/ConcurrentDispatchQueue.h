@@ -0,0 +1,121 @@
+#pragma once
+
+#include <bdn/DispatchQueue.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace bdn
+{
+    /** Executes functions on a pool of worker threads.
+
+        Offers the same dispatching interface as DispatchQueue, but functions
+        dispatched to a ConcurrentDispatchQueue may run in parallel and in no
+        particular order. Each worker owns a deque of pending functions. Work
+        dispatched from a worker thread is pushed onto that worker's own deque,
+        work dispatched from any other thread is distributed round robin. Idle
+        workers steal from the other workers' deques.
+
+        Delayed functions and timers are kept on an internal DispatchQueue and
+        handed to the workers once they are due.
+     */
+    class ConcurrentDispatchQueue
+    {
+      public:
+        using Function = DispatchQueue::Function;
+        using Clock = DispatchQueue::Clock;
+        using TimePoint = DispatchQueue::TimePoint;
+        using TimerFunction = DispatchQueue::TimerFunction;
+        using TimerHandle = DispatchQueue::TimerHandle;
+
+      public:
+        /** Creates the queue and starts numberOfWorkers threads. If
+            numberOfWorkers is 0 one worker per hardware thread is started. */
+        ConcurrentDispatchQueue(size_t numberOfWorkers = 0);
+        ~ConcurrentDispatchQueue();
+
+        ConcurrentDispatchQueue(const ConcurrentDispatchQueue &) = delete;
+        ConcurrentDispatchQueue &operator=(const ConcurrentDispatchQueue &) = delete;
+
+      public:
+        void dispatchAsync(Function function);
+        void dispatchSync(Function function);
+
+        template <class _Rep, class _Period>
+        TimerHandle dispatchAsyncDelayed(std::chrono::duration<_Rep, _Period> delay, Function function)
+        {
+            return _timedQueue.dispatchAsyncDelayed(
+                delay, [this, function = std::move(function)]() mutable { dispatchAsync(std::move(function)); });
+        }
+
+        /** Calls timer on one of the workers every interval until it returns
+            false or the timer is cancelled. A tick is skipped if the previous
+            call has not finished yet. */
+        template <class _Rep, class _Period>
+        TimerHandle createTimer(std::chrono::duration<_Rep, _Period> interval, TimerFunction timer)
+        {
+            return createTimerInternal(std::chrono::duration_cast<std::chrono::nanoseconds>(interval),
+                                       std::move(timer));
+        }
+
+#ifdef BDN_ENABLE_COROUTINES
+        /** co_await queue.schedule() continues the calling coroutine on one
+            of the workers */
+        ScheduleAwaitable<ConcurrentDispatchQueue> schedule()
+        {
+            return ScheduleAwaitable<ConcurrentDispatchQueue>(*this);
+        }
+
+        template <class _Rep, class _Period>
+        DelayAwaitable<ConcurrentDispatchQueue> scheduleAfter(std::chrono::duration<_Rep, _Period> delay)
+        {
+            return DelayAwaitable<ConcurrentDispatchQueue>(*this, std::chrono::duration_cast<Clock::duration>(delay));
+        }
+#endif
+
+      public:
+        void cancel();
+
+        size_t numberOfWorkers() const { return _workers.size(); }
+
+      private:
+        struct Worker
+        {
+            std::mutex mutex;
+            std::deque<Function> functions;
+            std::thread thread;
+        };
+
+      private:
+        TimerHandle createTimerInternal(std::chrono::nanoseconds interval, TimerFunction timer);
+
+        void push(size_t workerIndex, Function function);
+        bool popOwn(size_t workerIndex, Function &function);
+        bool steal(size_t thiefIndex, Function &function);
+
+        void workerThread(size_t workerIndex);
+
+        std::optional<size_t> currentWorkerIndex() const;
+
+      private:
+        std::vector<std::unique_ptr<Worker>> _workers;
+        std::atomic<size_t> _nextWorker{0};
+        std::atomic<size_t> _pending{0};
+        std::atomic<bool> _cancelled{false};
+        std::atomic<size_t> _idleWorkers{0};
+
+        std::mutex _idleMutex;
+        std::condition_variable _idleNotification;
+
+        // Declared last so that it is destroyed (and its thread is joined)
+        // before the workers go away.
+        DispatchQueue _timedQueue;
+    };
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <bdn/platform.h>
+
+#ifdef BDN_ENABLE_COROUTINES
+
+#include <bdn/Future.h>
+
+#include <array>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace bdn
+{
+    namespace detail
+    {
+        /** Recycles coroutine frames.
+
+            Freed frames are kept in per-thread free lists, one per size class,
+            so that coroutines that are started over and over again (like the
+            body of a request handler) do not hit the global allocator every
+            time. Frames may be freed on a different thread than they were
+            allocated on.
+         */
+        class CoroutineFrameAllocator
+        {
+          public:
+            static void *allocate(size_t size)
+            {
+                size_t sizeClass = sizeClassOf(size);
+                if (sizeClass >= NumberOfSizeClasses) {
+                    return ::operator new(size);
+                }
+
+                auto &list = freeLists()[sizeClass];
+                if (list.head != nullptr) {
+                    auto block = list.head;
+                    list.head = block->next;
+                    list.count--;
+                    return block;
+                }
+                return ::operator new((sizeClass + 1) * Granularity);
+            }
+
+            static void deallocate(void *pointer, size_t size) noexcept
+            {
+                size_t sizeClass = sizeClassOf(size);
+                if (sizeClass >= NumberOfSizeClasses) {
+                    ::operator delete(pointer);
+                    return;
+                }
+
+                auto &list = freeLists()[sizeClass];
+                if (list.count >= MaxCachedFrames) {
+                    ::operator delete(pointer);
+                    return;
+                }
+
+                auto block = static_cast<FreeBlock *>(pointer);
+                block->next = list.head;
+                list.head = block;
+                list.count++;
+            }
+
+          private:
+            static constexpr size_t Granularity = 64;
+            static constexpr size_t NumberOfSizeClasses = 32;
+            static constexpr size_t MaxCachedFrames = 64;
+
+            struct FreeBlock
+            {
+                FreeBlock *next;
+            };
+
+            struct FreeList
+            {
+                ~FreeList()
+                {
+                    while (head != nullptr) {
+                        auto next = head->next;
+                        ::operator delete(head);
+                        head = next;
+                    }
+                }
+
+                FreeBlock *head = nullptr;
+                size_t count = 0;
+            };
+
+            static size_t sizeClassOf(size_t size) { return (size - 1) / Granularity; }
+
+            static std::array<FreeList, NumberOfSizeClasses> &freeLists()
+            {
+                thread_local std::array<FreeList, NumberOfSizeClasses> lists;
+                return lists;
+            }
+        };
+
+        /** Resumes a coroutine once. If it is destroyed without having been
+            called, e.g. because the queue it was dispatched to was cancelled,
+            the coroutine is destroyed instead of being leaked. */
+        class CoroutineResumer
+        {
+          public:
+            explicit CoroutineResumer(std::coroutine_handle<> handle) : _handle(handle) {}
+            CoroutineResumer(CoroutineResumer &&other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+            CoroutineResumer(const CoroutineResumer &) = delete;
+            ~CoroutineResumer()
+            {
+                if (_handle) {
+                    _handle.destroy();
+                }
+            }
+
+            void operator()() { std::exchange(_handle, nullptr).resume(); }
+
+          private:
+            std::coroutine_handle<> _handle;
+        };
+
+        template <class T> class FuturePromiseBase
+        {
+          public:
+            Future<T> get_return_object() { return _promise.future(); }
+
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+
+            void unhandled_exception() { _promise.setException(std::current_exception()); }
+
+            static void *operator new(size_t size) { return CoroutineFrameAllocator::allocate(size); }
+            static void operator delete(void *pointer, size_t size) noexcept
+            {
+                CoroutineFrameAllocator::deallocate(pointer, size);
+            }
+
+          protected:
+            Promise<T> _promise;
+        };
+
+        template <class T> class FuturePromise : public FuturePromiseBase<T>
+        {
+          public:
+            template <class U> void return_value(U &&value) { this->_promise.setValue(std::forward<U>(value)); }
+        };
+
+        template <> class FuturePromise<void> : public FuturePromiseBase<void>
+        {
+          public:
+            void return_void() { this->_promise.setValue(); }
+        };
+
+        template <class T> class FutureAwaiter
+        {
+          public:
+            explicit FutureAwaiter(Future<T> &&future) : _state(std::move(future._state)) {}
+
+            bool await_ready() { return _state->isReady(); }
+
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                UniqueFunction<void()> resume = [handle]() { handle.resume(); };
+                return _state->tryOnReady(resume);
+            }
+
+            T await_resume()
+            {
+                if (auto exception = _state->exception()) {
+                    std::rethrow_exception(exception);
+                }
+                if constexpr (!std::is_void_v<T>) {
+                    return _state->takeValue();
+                }
+            }
+
+          private:
+            std::shared_ptr<FutureState<T>> _state;
+        };
+    }
+
+    /** Returned by DispatchQueue::schedule() and
+        ConcurrentDispatchQueue::schedule(). Awaiting it continues the
+        coroutine on the queue. */
+    template <class Queue> class ScheduleAwaitable
+    {
+      public:
+        explicit ScheduleAwaitable(Queue &queue) : _queue(queue) {}
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { _queue.dispatchAsync(detail::CoroutineResumer(handle)); }
+        void await_resume() const noexcept {}
+
+      private:
+        Queue &_queue;
+    };
+
+    /** Returned by DispatchQueue::scheduleAfter() and
+        ConcurrentDispatchQueue::scheduleAfter(). Awaiting it continues the
+        coroutine on the queue once the delay has passed. */
+    template <class Queue> class DelayAwaitable
+    {
+      public:
+        DelayAwaitable(Queue &queue, std::chrono::steady_clock::duration delay) : _queue(queue), _delay(delay) {}
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            _queue.dispatchAsyncDelayed(_delay, detail::CoroutineResumer(handle));
+        }
+        void await_resume() const noexcept {}
+
+      private:
+        Queue &_queue;
+        std::chrono::steady_clock::duration _delay;
+    };
+
+    /** Suspends the coroutine until future is ready. The coroutine continues
+        on the thread that completes the future. */
+    template <class T> detail::FutureAwaiter<T> operator co_await(Future<T> &&future)
+    {
+        return detail::FutureAwaiter<T>(std::move(future));
+    }
+}
+
+/** Allows Future<T> to be used as the return type of coroutines */
+template <class T, class... Arguments> struct std::coroutine_traits<bdn::Future<T>, Arguments...>
+{
+    using promise_type = bdn::detail::FuturePromise<T>;
+};
+
+#endif
@@ -1,29 +1,289 @@
 #pragma once
 
+#include <bdn/TimerWheel.h>
+#include <bdn/UniqueFunction.h>
+#include <bdn/platform.h>
+
+#ifdef BDN_ENABLE_COROUTINES
+#include <bdn/Coroutine.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
-#include <future>
-#include <map>
+#include <condition_variable>
+#include <exception>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
-#include <queue>
 #include <thread>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
 
 namespace bdn
 {
     class DispatchQueue
     {
       public:
-        using Function = std::function<void()>;
+        using Function = UniqueFunction<void()>;
         using Clock = std::chrono::steady_clock;
         using TimePoint = Clock::time_point;
 
+        using TimerFunction = UniqueFunction<bool()>;
+
+        /** Immediate work is kept in one lane per priority. Higher lanes are
+            served first, see dispatchAsync(Priority, Function). */
+        enum class Priority
+        {
+            UserInteractive,
+            Default,
+            Utility,
+            Background
+        };
+        static constexpr size_t NumberOfPriorities = 4;
+
+        struct LaneStatistics
+        {
+            /** Number of functions waiting in the lane */
+            size_t depth = 0;
+            size_t executed = 0;
+            /** Number of functions that were started after their deadline */
+            size_t overdue = 0;
+            Clock::duration totalWait{};
+            Clock::duration maxWait{};
+
+            Clock::duration averageWait() const
+            {
+                return executed == 0 ? Clock::duration::zero() : totalWait / static_cast<Clock::rep>(executed);
+            }
+        };
+
+        /** Time slicing used by enterFrameLoop() */
+        struct FrameBudget
+        {
+            /** Time between the starts of two consecutive frames */
+            Clock::duration interval = std::chrono::microseconds(16667);
+            /** How long timers and immediate work may run per frame */
+            Clock::duration budget = std::chrono::milliseconds(8);
+            /** How far a frame may run past its budget before it counts as an
+                overrun. The function running when the budget is used up is
+                finished, so a frame with more work ends a little late. */
+            Clock::duration overrunTolerance = std::chrono::milliseconds(1);
+        };
+
+        struct FrameStatistics
+        {
+            size_t frames = 0;
+            /** Number of frames that left immediate work to the next frame */
+            size_t cutShort = 0;
+            /** Number of frames that exceeded their budget by more than the
+                overrun tolerance */
+            size_t overruns = 0;
+            Clock::duration lastFrame{};
+            Clock::duration maxFrame{};
+            Clock::duration totalFrame{};
+            /** Sum of the time by which overrun frames exceeded their budget */
+            Clock::duration totalOverrun{};
+
+            Clock::duration averageFrame() const
+            {
+                return frames == 0 ? Clock::duration::zero() : totalFrame / static_cast<Clock::rep>(frames);
+            }
+        };
+
+        /** Refers to a delayed function or a timer. cancel() removes it from
+            the queue, a function that is executing at that moment finishes
+            but is not called again.
+
+            A handle must not be used after its queue has been destroyed.
+         */
+        class TimerHandle
+        {
+          public:
+            TimerHandle() = default;
+
+            void cancel()
+            {
+                if (_queue != nullptr) {
+                    _queue->cancelTimed(_id);
+                    _queue = nullptr;
+                }
+            }
+
+            bool isValid() const { return _queue != nullptr; }
+
+          private:
+            friend class DispatchQueue;
+            TimerHandle(DispatchQueue *queue, uint64_t id) : _queue(queue), _id(id) {}
+
+            DispatchQueue *_queue = nullptr;
+            uint64_t _id = 0;
+        };
+
       protected:
         using MutexType = std::mutex;
         using LockType = std::unique_lock<MutexType>;
 
+      private:
+        using TimedFunction = std::variant<Function, TimerFunction>;
+
+        /** State of a pending dispatchSync() call. Lives on the waiting thread's
+            stack, all fields are guarded by the queue mutex. */
+        struct SyncTask
+        {
+            std::condition_variable notification;
+            bool started = false;
+            bool done = false;
+            std::exception_ptr exception;
+
+            SyncTask *previous = nullptr;
+            SyncTask *next = nullptr;
+        };
+
+        /** Intrusive multi-producer/single-consumer queue for immediate work.
+
+            push() is lock-free and may be called from any thread. pop() and
+            empty() may only be called by one consumer at a time, the
+            DispatchQueue serializes them via its queue mutex.
+         */
+        class ImmediateQueue
+        {
+          public:
+            struct Node
+            {
+                Node() = default;
+                Node(Function f) : function(std::move(f)) {}
+
+                std::atomic<Node *> next{nullptr};
+                Function function;
+                SyncTask *syncTask = nullptr;
+                TimePoint enqueued;
+                TimePoint deadline = TimePoint::max();
+                Priority priority = Priority::Default;
+            };
+
+          public:
+            ImmediateQueue() = default;
+            ImmediateQueue(const ImmediateQueue &) = delete;
+            ~ImmediateQueue() { clear(); }
+
+            void push(Node *node)
+            {
+                node->next.store(nullptr, std::memory_order_relaxed);
+                Node *previous = _head.exchange(node);
+                previous->next.store(node, std::memory_order_release);
+            }
+
+            std::unique_ptr<Node> pop()
+            {
+                Node *tail = _tail;
+                Node *next = tail->next.load(std::memory_order_acquire);
+
+                if (tail == &_stub) {
+                    if (next == nullptr) {
+                        return nullptr;
+                    }
+                    _tail = next;
+                    tail = next;
+                    next = next->next.load(std::memory_order_acquire);
+                }
+
+                if (next != nullptr) {
+                    _tail = next;
+                    return std::unique_ptr<Node>(tail);
+                }
+
+                if (tail != _head.load()) {
+                    // A producer has claimed the head but not linked its node yet
+                    return nullptr;
+                }
+
+                push(&_stub);
+
+                next = tail->next.load(std::memory_order_acquire);
+                if (next != nullptr) {
+                    _tail = next;
+                    return std::unique_ptr<Node>(tail);
+                }
+
+                return nullptr;
+            }
+
+            /** Only true if no node is left at all. Checking _head alone is
+                not enough: a producer may push while pop() re-inserts the
+                stub, which leaves _head at the stub while _tail still points
+                to the producer's node. */
+            bool empty() const
+            {
+                return _tail == &_stub && _stub.next.load(std::memory_order_acquire) == nullptr &&
+                       _head.load() == &_stub;
+            }
+
+            /** The node pop() returns next (if it is completely linked
+                already), or nullptr. */
+            const Node *front() const
+            {
+                const Node *tail = _tail;
+                if (tail == &_stub) {
+                    tail = tail->next.load(std::memory_order_acquire);
+                }
+                return tail;
+            }
+
+            void clear()
+            {
+                while (pop()) {
+                }
+            }
+
+          private:
+            Node _stub;
+            std::atomic<Node *> _head{&_stub};
+            Node *_tail{&_stub};
+        };
+
+        using Node = ImmediateQueue::Node;
+
+        struct Lane
+        {
+            ImmediateQueue queue;
+            /** Heap of the functions with a deadline, earliest first. Guarded
+                by the queue mutex. */
+            std::vector<std::unique_ptr<Node>> deadlineNodes;
+            std::atomic<size_t> depth{0};
+            Clock::duration starvationLimit;
+
+            size_t executed = 0;
+            size_t overdue = 0;
+            Clock::duration totalWait{};
+            Clock::duration maxWait{};
+        };
+
+        /** State of a key passed to dispatchAsyncCoalesced() and friends. Only
+            exists while something is pending for the key. */
+        struct CoalescedFunction
+        {
+            /** The function to run next, empty if it already ran */
+            Function function;
+            /** A node that runs the function is waiting in the lanes */
+            bool queued = false;
+            /** Pending debounce delay or running throttle interval */
+            TimerWheel<TimedFunction>::Id timerId = TimerWheel<TimedFunction>::InvalidId;
+            Clock::duration throttleInterval{};
+        };
+
       public:
         DispatchQueue(bool slave = false) : _slave(slave)
         {
+            lane(Priority::UserInteractive).starvationLimit = Clock::duration::max();
+            lane(Priority::Default).starvationLimit = std::chrono::milliseconds(50);
+            lane(Priority::Utility).starvationLimit = std::chrono::milliseconds(250);
+            lane(Priority::Background).starvationLimit = std::chrono::seconds(1);
+
             if (!_slave) {
                 _thread = std::make_unique<std::thread>(std::bind(&DispatchQueue::workerThread, this));
                 _threadId = _thread->get_id();
@@ -39,74 +299,233 @@ namespace bdn
         }
 
       public:
-        void dispatchAsync(Function function)
+        void dispatchAsync(Function function) { dispatchAsync(Priority::Default, std::move(function)); }
+
+        /** Dispatches function to the lane of the given priority.
+
+            The queue always runs the oldest function of the highest non-empty
+            lane, unless the oldest function of a lower lane has waited longer
+            than that lane's starvation limit (see setStarvationLimit()).
+         */
+        void dispatchAsync(Priority priority, Function function)
+        {
+            if (_cancelled) {
+                return;
+            }
+
+            push(makeNode(priority, std::move(function)));
+            wakeUp();
+        }
+
+        /** Dispatches a function that should run no later than deadline.
+
+            Functions with a deadline are kept in deadline order per priority.
+            Until their deadline they compete with the other functions of their
+            priority, once it has passed they are run before all other work.
+         */
+        void dispatchAsync(Priority priority, TimePoint deadline, Function function)
         {
+            if (_cancelled) {
+                return;
+            }
+
+            auto node = makeNode(priority, std::move(function));
+            node->deadline = deadline;
+
             LockType lk(_queueMutex);
-            dispatchAsync(std::move(function), lk);
+            if (_cancelled) {
+                return;
+            }
+            auto &l = lane(priority);
+            l.depth++;
+            l.deadlineNodes.push_back(std::move(node));
+            std::push_heap(l.deadlineNodes.begin(), l.deadlineNodes.end(), laterDeadline);
+            notifyWorker(lk);
         }
 
-        void dispatchSync(Function function)
+        void dispatchSync(Function function) { dispatchSync(Priority::Default, std::move(function)); }
+
+        void dispatchSync(Priority priority, Function function)
         {
             if (std::this_thread::get_id() == _threadId) {
                 function();
                 return;
             }
 
+            SyncTask task;
+            auto node = makeNode(priority, std::move(function));
+            node->syncTask = &task;
+
             LockType lk(_queueMutex);
             if (_cancelled) {
                 return;
             }
+            addSyncTask(&task);
+            lk.unlock();
 
-            std::packaged_task<void()> task(function);
-            auto future = task.get_future();
-            dispatchAsync(std::ref(task), lk);
+            push(std::move(node));
+            wakeUp();
 
+            lk.lock();
+            // Once the queue is cancelled nothing is taken from it anymore, so
+            // a task that has not been started yet never will be.
+            task.notification.wait(lk, [&]() { return task.done || (_cancelled && !task.started); });
+            removeSyncTask(&task);
             lk.unlock();
-            while (!_cancelled) {
-                if (future.wait_for(std::chrono::milliseconds(10)) == std::future_status::ready)
-                    break;
+
+            if (task.exception) {
+                std::rethrow_exception(task.exception);
+            }
+        }
+
+        /** Runs function after the immediate work that is currently processed.
+            In a frame loop (see enterFrameLoop()) this is the end of the
+            current frame.
+
+            Functions dispatched with the same non-null key before they ran are
+            coalesced, only the one dispatched last is called. This is meant
+            for passes like layout that should happen at most once per frame.
+         */
+        void dispatchAtFrameEnd(const void *key, Function function)
+        {
+            LockType lk(_queueMutex);
+            if (_cancelled) {
+                return;
             }
+
+            auto it = std::find_if(_frameEndFunctions.begin(), _frameEndFunctions.end(),
+                                   [key](const auto &entry) { return key != nullptr && entry.first == key; });
+            if (it != _frameEndFunctions.end()) {
+                it->second = std::move(function);
+            } else {
+                _frameEndFunctions.emplace_back(key, std::move(function));
+            }
+            notifyWorker(lk);
+        }
+
+        /** Dispatches function unless a function with the same key is already
+            waiting to be run, in which case that function is replaced.
+
+            Keys are shared between dispatchAsyncCoalesced(),
+            dispatchAsyncDebounced() and dispatchAsyncThrottled(), a key should
+            only be used with one of them at a time.
+         */
+        void dispatchAsyncCoalesced(const void *key, Function function)
+        {
+            LockType lk(_queueMutex);
+            if (_cancelled) {
+                return;
+            }
+
+            auto &entry = _coalescedFunctions[key];
+            entry.function = std::move(function);
+            if (!entry.queued && entry.timerId == TimerWheel<TimedFunction>::InvalidId) {
+                queueCoalesced(lk, key, entry);
+            }
+        }
+
+        /** Runs function once no other function has been dispatched with the
+            same key for delay. Every call restarts the delay and replaces the
+            pending function. */
+        template <class _Rep, class _Period>
+        void dispatchAsyncDebounced(const void *key, std::chrono::duration<_Rep, _Period> delay, Function function)
+        {
+            dispatchDebounced(key, std::chrono::duration_cast<Clock::duration>(delay), std::move(function));
         }
 
+        /** Runs function right away, unless a function with the same key has
+            been run within the last interval. In that case function replaces
+            the pending one and is run when the interval has passed. */
         template <class _Rep, class _Period>
-        void dispatchAsyncDelayed(std::chrono::duration<_Rep, _Period> delay, Function function)
+        void dispatchAsyncThrottled(const void *key, std::chrono::duration<_Rep, _Period> interval, Function function)
+        {
+            dispatchThrottled(key, std::chrono::duration_cast<Clock::duration>(interval), std::move(function));
+        }
+
+        /** Drops the function pending for key, if any */
+        void cancelCoalesced(const void *key)
+        {
+            LockType lk(_queueMutex);
+
+            auto it = _coalescedFunctions.find(key);
+            if (it == _coalescedFunctions.end()) {
+                return;
+            }
+            _timers.cancel(it->second.timerId);
+            _coalescedFunctions.erase(it);
+        }
+
+        template <class _Rep, class _Period>
+        TimerHandle dispatchAsyncDelayed(std::chrono::duration<_Rep, _Period> delay, Function function)
         {
             LockType lk(_queueMutex);
 
             TimePoint executeTimePoint = Clock::now() + std::chrono::duration_cast<Clock::duration>(delay);
-            _timedQueue[executeTimePoint].push(std::move(function));
+            auto id = _timers.add(executeTimePoint, TimedFunction(std::move(function)));
             newTimed(lk);
             notifyWorker(lk);
+
+            return makeTimerHandle(id);
         }
 
         template <class _Rep, class _Period>
-        void createTimer(std::chrono::duration<_Rep, _Period> interval, std::function<bool()> timer)
+        TimerHandle createTimer(std::chrono::duration<_Rep, _Period> interval, TimerFunction timer)
         {
             auto intervalInSeconds = std::chrono::duration_cast<std::chrono::duration<double>>(interval);
-            createTimerInternal(intervalInSeconds, timer);
+            return createTimerInternal(intervalInSeconds, std::move(timer));
         }
 
+#ifdef BDN_ENABLE_COROUTINES
+        /** co_await queue.schedule() continues the calling coroutine on this
+            queue */
+        ScheduleAwaitable<DispatchQueue> schedule() { return ScheduleAwaitable<DispatchQueue>(*this); }
+
+        /** co_await queue.scheduleAfter(delay) continues the calling coroutine
+            on this queue once delay has passed */
+        template <class _Rep, class _Period>
+        DelayAwaitable<DispatchQueue> scheduleAfter(std::chrono::duration<_Rep, _Period> delay)
+        {
+            return DelayAwaitable<DispatchQueue>(*this, std::chrono::duration_cast<Clock::duration>(delay));
+        }
+#endif
+
       public:
         void enter()
         {
-            if (_thread) {
-                throw std::logic_error("This queue is already served by its own thread!");
-            }
-            if (_cancelled) {
-                throw std::logic_error("This queue is already cancelled!");
-            }
-
-            _threadId = std::this_thread::get_id();
+            prepareEnter();
 
             workerThread();
 
             LockType lk(_queueMutex);
             emptyQueues(lk);
         }
+
+        /** Like enter(), but processes the queue in frames.
+
+            Every frame first runs the due timers, then immediate work until
+            the frame's budget is used up and finally the functions dispatched
+            with dispatchAtFrameEnd(). Immediate work that did not fit into
+            the budget is continued in the next frame, which starts one
+            interval after the current one. This keeps a burst of work from
+            delaying timers and frame end functions until all of it has been
+            processed.
+         */
+        void enterFrameLoop(FrameBudget frameBudget)
+        {
+            prepareEnter();
+
+            LockType lk(_queueMutex);
+            frameLoop(lk, frameBudget);
+            emptyQueues(lk);
+        }
+
         void cancel()
         {
             LockType lk(_queueMutex);
             _cancelled = true;
+            for (auto task = _syncTasks; task != nullptr; task = task->next) {
+                task->notification.notify_one();
+            }
             notifyWorker(lk);
         }
         void executeSync()
@@ -119,69 +538,405 @@ namespace bdn
             executeNext(lk);
         }
 
+      public:
+        /** Sets how long the oldest function of a lane may wait before it is
+            run ahead of the functions in higher lanes. */
+        void setStarvationLimit(Priority priority, Clock::duration limit)
+        {
+            LockType lk(_queueMutex);
+            lane(priority).starvationLimit = limit;
+        }
+
+        LaneStatistics statistics(Priority priority)
+        {
+            LockType lk(_queueMutex);
+
+            auto &l = lane(priority);
+
+            LaneStatistics result;
+            result.depth = l.depth;
+            result.executed = l.executed;
+            result.overdue = l.overdue;
+            result.totalWait = l.totalWait;
+            result.maxWait = l.maxWait;
+            return result;
+        }
+
+        void resetStatistics()
+        {
+            LockType lk(_queueMutex);
+            for (auto &l : _lanes) {
+                l.executed = 0;
+                l.overdue = 0;
+                l.totalWait = Clock::duration::zero();
+                l.maxWait = Clock::duration::zero();
+            }
+        }
+
+        FrameStatistics frameStatistics()
+        {
+            LockType lk(_queueMutex);
+            return _frameStatistics;
+        }
+
+        void resetFrameStatistics()
+        {
+            LockType lk(_queueMutex);
+            _frameStatistics = FrameStatistics();
+        }
+
       protected:
         virtual void notifyWorker(LockType &lk) { _notification.notify_all(); }
         virtual void newTimed(LockType &lk) { _nTimed++; }
-        virtual void createTimerInternal(std::chrono::duration<double> interval, std::function<bool()> timer)
+        virtual TimerHandle createTimerInternal(std::chrono::duration<double> interval, TimerFunction timer)
         {
-            auto delayInNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(interval);
-            dispatchAsyncDelayed(interval, Timer{this, delayInNanoseconds, timer});
+            LockType lk(_queueMutex);
+
+            auto intervalInClockTicks = std::chrono::duration_cast<Clock::duration>(interval);
+            auto id =
+                _timers.add(Clock::now() + intervalInClockTicks, TimedFunction(std::move(timer)), intervalInClockTicks);
+            newTimed(lk);
+            notifyWorker(lk);
+
+            return makeTimerHandle(id);
         }
 
+        virtual void cancelTimed(uint64_t id)
+        {
+            LockType lk(_queueMutex);
+            _timers.cancel(id);
+        }
+
+        TimerHandle makeTimerHandle(uint64_t id) { return TimerHandle(this, id); }
+
       private:
-        void dispatchAsync(Function function, LockType &lk)
+        /** Signals the worker unless a wake up is already pending. The flag is
+            cleared by the worker before it looks at the queue for the last
+            time, so producers only pay for the notification (and the mutex)
+            when the worker may actually be parked. */
+        void wakeUp()
         {
+            if (!_wakeUpPending.exchange(true)) {
+                LockType lk(_queueMutex);
+                notifyWorker(lk);
+            }
+        }
+
+        Lane &lane(Priority priority) { return _lanes[static_cast<size_t>(priority)]; }
+
+        std::unique_ptr<Node> makeNode(Priority priority, Function function)
+        {
+            auto node = std::make_unique<Node>(std::move(function));
+            node->priority = priority;
+            node->enqueued = Clock::now();
+            return node;
+        }
+
+        void push(std::unique_ptr<Node> node)
+        {
+            auto &l = lane(node->priority);
+            l.depth++;
+            l.queue.push(node.release());
+        }
+
+        void queueCoalesced(LockType &lk, const void *key, CoalescedFunction &entry)
+        {
+            entry.queued = true;
+            push(makeNode(Priority::Default, [this, key]() { runCoalesced(key, false); }));
+            notifyWorker(lk);
+        }
+
+        void armCoalescedTimer(LockType &lk, const void *key, CoalescedFunction &entry, Clock::duration delay)
+        {
+            entry.timerId =
+                _timers.add(Clock::now() + delay, TimedFunction(Function([this, key]() { runCoalesced(key, true); })));
+            newTimed(lk);
+            notifyWorker(lk);
+        }
+
+        void dispatchDebounced(const void *key, Clock::duration delay, Function function)
+        {
+            LockType lk(_queueMutex);
             if (_cancelled) {
                 return;
             }
 
-            _queue.push(std::move(function));
-            notifyWorker(lk);
+            auto &entry = _coalescedFunctions[key];
+            entry.function = std::move(function);
+            _timers.cancel(entry.timerId);
+            armCoalescedTimer(lk, key, entry, delay);
+        }
+
+        void dispatchThrottled(const void *key, Clock::duration interval, Function function)
+        {
+            LockType lk(_queueMutex);
+            if (_cancelled) {
+                return;
+            }
+
+            auto &entry = _coalescedFunctions[key];
+            entry.function = std::move(function);
+
+            if (entry.timerId == TimerWheel<TimedFunction>::InvalidId) {
+                // No interval is running, run now and start one
+                entry.throttleInterval = interval;
+                armCoalescedTimer(lk, key, entry, interval);
+                if (!entry.queued) {
+                    queueCoalesced(lk, key, entry);
+                }
+            }
+        }
+
+        /** Called by the queued node (fromTimer == false) or by the debounce
+            delay / throttle interval timer of a coalesced function. */
+        void runCoalesced(const void *key, bool fromTimer)
+        {
+            LockType lk(_queueMutex);
+
+            auto it = _coalescedFunctions.find(key);
+            if (it == _coalescedFunctions.end()) {
+                return;
+            }
+            auto &entry = it->second;
+
+            if (fromTimer) {
+                entry.timerId = TimerWheel<TimedFunction>::InvalidId;
+                if (entry.throttleInterval != Clock::duration::zero() && entry.function) {
+                    // Calls came in during the interval, run the last one and
+                    // start the next interval
+                    armCoalescedTimer(lk, key, entry, entry.throttleInterval);
+                }
+            } else {
+                entry.queued = false;
+            }
+
+            auto function = std::move(entry.function);
+            entry.function = nullptr;
+
+            if (!entry.queued && entry.timerId == TimerWheel<TimedFunction>::InvalidId) {
+                _coalescedFunctions.erase(it);
+            }
+
+            lk.unlock();
+            if (function) {
+                function();
+            }
+        }
+
+        static bool laterDeadline(const std::unique_ptr<Node> &a, const std::unique_ptr<Node> &b)
+        {
+            return a->deadline > b->deadline;
+        }
+
+        bool hasImmediateWork() const
+        {
+            for (auto &l : _lanes) {
+                if (!l.deadlineNodes.empty() || !l.queue.empty()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static const Node *earliestDeadline(const Lane &l)
+        {
+            return l.deadlineNodes.empty() ? nullptr : l.deadlineNodes.front().get();
+        }
+
+        static std::unique_ptr<Node> takeDeadlineNode(Lane &l)
+        {
+            std::pop_heap(l.deadlineNodes.begin(), l.deadlineNodes.end(), laterDeadline);
+            auto node = std::move(l.deadlineNodes.back());
+            l.deadlineNodes.pop_back();
+            return node;
+        }
+
+        /** Takes the function of lane l that was enqueued first */
+        static std::unique_ptr<Node> takeOldest(Lane &l)
+        {
+            auto deadlineNode = earliestDeadline(l);
+            auto front = l.queue.front();
+
+            if (deadlineNode != nullptr && (front == nullptr || deadlineNode->enqueued < front->enqueued)) {
+                return takeDeadlineNode(l);
+            }
+            return l.queue.pop();
+        }
+
+        /** Picks the next function to run. Must be called with the queue mutex
+            held, since the lanes only support a single consumer. */
+        std::unique_ptr<Node> takeNext(TimePoint now)
+        {
+            // Overdue functions first, the one with the earliest deadline of
+            // all lanes
+            Lane *overdueLane = nullptr;
+            for (auto &l : _lanes) {
+                auto deadlineNode = earliestDeadline(l);
+                if (deadlineNode != nullptr && deadlineNode->deadline <= now &&
+                    (overdueLane == nullptr || deadlineNode->deadline < earliestDeadline(*overdueLane)->deadline)) {
+                    overdueLane = &l;
+                }
+            }
+            if (overdueLane != nullptr) {
+                return takeDeadlineNode(*overdueLane);
+            }
+
+            for (auto &l : _lanes) {
+                auto front = l.queue.front();
+                auto deadlineNode = earliestDeadline(l);
+                if ((front != nullptr && now - front->enqueued >= l.starvationLimit) ||
+                    (deadlineNode != nullptr && now - deadlineNode->enqueued >= l.starvationLimit)) {
+                    return takeOldest(l);
+                }
+            }
+
+            // Within a lane, functions with a deadline compete with the others
+            // by the time they were enqueued
+            for (auto &l : _lanes) {
+                if (!l.deadlineNodes.empty() || !l.queue.empty()) {
+                    return takeOldest(l);
+                }
+            }
+            return nullptr;
         }
 
         void executeNext(LockType &lk)
         {
-            if (_queue.empty()) {
+            if (_cancelled) {
+                return;
+            }
+
+            auto now = Clock::now();
+            auto next = takeNext(now);
+            if (!next) {
                 return;
             }
 
-            auto &next = _queue.front();
+            auto &l = lane(next->priority);
+            auto wait = now - next->enqueued;
+            l.depth--;
+            l.executed++;
+            l.totalWait += wait;
+            l.maxWait = std::max(l.maxWait, wait);
+            if (next->deadline < now) {
+                l.overdue++;
+            }
+
+            SyncTask *syncTask = next->syncTask;
+            if (syncTask == nullptr) {
+                lk.unlock();
+                next->function();
+                next.reset();
+                lk.lock();
+                return;
+            }
+
+            syncTask->started = true;
             lk.unlock();
-            (next)();
+
+            std::exception_ptr exception;
+            try {
+                next->function();
+            }
+            catch (...) {
+                exception = std::current_exception();
+            }
+            next.reset();
+
             lk.lock();
-            _queue.pop();
+            syncTask->exception = exception;
+            syncTask->done = true;
+            syncTask->notification.notify_one();
+        }
+
+        void addSyncTask(SyncTask *task)
+        {
+            task->next = _syncTasks;
+            if (_syncTasks != nullptr) {
+                _syncTasks->previous = task;
+            }
+            _syncTasks = task;
+        }
+
+        void removeSyncTask(SyncTask *task)
+        {
+            if (task->previous != nullptr) {
+                task->previous->next = task->next;
+            } else {
+                _syncTasks = task->next;
+            }
+            if (task->next != nullptr) {
+                task->next->previous = task->previous;
+            }
         }
 
         std::optional<TimePoint> processTimed(LockType &lk)
         {
-            while (!_timedQueue.empty() && !_cancelled) {
-                auto it = _timedQueue.begin();
-                if (it->first <= Clock::now()) {
-                    while (!it->second.empty() && !_cancelled) {
-                        auto &f = it->second.front();
-                        lk.unlock();
-                        f();
-                        lk.lock();
-                        it->second.pop();
-                    }
-                    _timedQueue.erase(it);
-                } else {
-                    break;
+            _timers.advance(Clock::now());
+
+            TimerWheel<TimedFunction>::Id id;
+            TimedFunction function;
+            while (!_cancelled && _timers.takeDue(id, function)) {
+                lk.unlock();
+
+                bool again = false;
+                try {
+                    again = callTimed(function);
+                }
+                catch (...) {
+                    lk.lock();
+                    _timers.finish(id, TimedFunction(), false, Clock::now());
+                    throw;
                 }
+
+                lk.lock();
+                _timers.finish(id, std::move(function), again, Clock::now());
+                function = TimedFunction();
             }
-            if (!_timedQueue.empty()) {
-                return _timedQueue.begin()->first;
+
+            return _timers.nextExpiry();
+        }
+
+        void processFrameEnd(LockType &lk)
+        {
+            if (_frameEndFunctions.empty() || _cancelled) {
+                return;
             }
 
-            return std::nullopt;
+            // Functions dispatched from here on belong to the next frame
+            auto functions = std::move(_frameEndFunctions);
+            _frameEndFunctions.clear();
+
+            lk.unlock();
+            try {
+                for (auto &entry : functions) {
+                    entry.second();
+                }
+            }
+            catch (...) {
+                lk.lock();
+                throw;
+            }
+            lk.lock();
+        }
+
+        static bool callTimed(TimedFunction &function)
+        {
+            if (auto timer = std::get_if<TimerFunction>(&function)) {
+                return (*timer)();
+            }
+            std::get<Function>(function)();
+            return false;
         }
 
       protected:
         std::optional<TimePoint> processQueue(LockType &lk)
         {
+            _wakeUpPending = false;
+
             auto nextTimed = processTimed(lk);
 
-            while (!_queue.empty()) {
+            while (hasImmediateWork() && !_cancelled) {
                 executeNext(lk);
                 if (nextTimed) {
                     if (Clock::now() >= *nextTimed)
@@ -189,20 +944,41 @@ namespace bdn
                 }
             }
 
-            return nextTimed;
+            processFrameEnd(lk);
+
+            // The functions might have added timers themselves
+            return _timers.nextExpiry();
         }
 
         std::mutex &queueMutex() { return _queueMutex; }
 
         void emptyQueues(LockType &lk)
         {
-            while (!_queue.empty()) {
-                _queue.pop();
+            for (auto &l : _lanes) {
+                l.queue.clear();
+                l.deadlineNodes.clear();
+                l.depth = 0;
             }
-            _timedQueue.clear();
+            _frameEndFunctions.clear();
+            _coalescedFunctions.clear();
+            _timers.clear();
         }
 
       private:
+        void prepareEnter()
+        {
+            if (_thread) {
+                throw std::logic_error("This queue is already served by its own thread!");
+            }
+            if (_cancelled) {
+                throw std::logic_error("This queue is already cancelled!");
+            }
+
+            _threadId = std::this_thread::get_id();
+        }
+
+        bool hasWork() const { return hasImmediateWork() || !_frameEndFunctions.empty(); }
+
         void workerThread()
         {
             int oldTimed = -1;
@@ -216,30 +992,70 @@ namespace bdn
                 nextTimed = processQueue(lk);
                 oldTimed = _nTimed;
 
+                // From here on producers have to wake us up again. This has to
+                // happen before the predicates below look at the queue.
+                _wakeUpPending = false;
+
                 if (nextTimed) {
                     _notification.wait_until(lk, *nextTimed,
-                                             [&]() { return _cancelled || !_queue.empty() || _nTimed != oldTimed; });
+                                             [&]() { return _cancelled || hasWork() || _nTimed != oldTimed; });
                 } else {
-                    _notification.wait(lk, [&]() { return _cancelled || !_queue.empty() || _nTimed != oldTimed; });
+                    _notification.wait(lk, [&]() { return _cancelled || hasWork() || _nTimed != oldTimed; });
                 }
             }
         }
 
-      private:
-        class Timer
+        void frameLoop(LockType &lk, const FrameBudget &frameBudget)
         {
-          public:
-            void operator()()
-            {
-                if (_function()) {
-                    _queue->dispatchAsyncDelayed(_interval, std::move(*this));
+            while (!_cancelled) {
+                auto frameStart = Clock::now();
+                auto budgetEnd = frameStart + frameBudget.budget;
+
+                _wakeUpPending = false;
+                processTimed(lk);
+
+                // Always make progress, even if the timers used up the budget
+                bool first = true;
+                while (hasImmediateWork() && !_cancelled && (first || Clock::now() < budgetEnd)) {
+                    executeNext(lk);
+                    first = false;
+                }
+                bool cutShort = hasImmediateWork() && !_cancelled;
+
+                processFrameEnd(lk);
+
+                recordFrame(Clock::now() - frameStart, frameBudget, cutShort);
+
+                int oldTimed = _nTimed;
+                _wakeUpPending = false;
+
+                if (hasWork()) {
+                    // Leave the rest of the frame to whoever else needs it
+                    _notification.wait_until(lk, frameStart + frameBudget.interval,
+                                             [&]() { return _cancelled.load(); });
+                } else if (auto nextTimed = _timers.nextExpiry()) {
+                    _notification.wait_until(lk, *nextTimed,
+                                             [&]() { return _cancelled || hasWork() || _nTimed != oldTimed; });
+                } else {
+                    _notification.wait(lk, [&]() { return _cancelled || hasWork() || _nTimed != oldTimed; });
                 }
             }
+        }
 
-            DispatchQueue *_queue = nullptr;
-            std::chrono::nanoseconds _interval;
-            std::function<bool()> _function;
-        };
+        void recordFrame(Clock::duration duration, const FrameBudget &frameBudget, bool cutShort)
+        {
+            _frameStatistics.frames++;
+            _frameStatistics.lastFrame = duration;
+            _frameStatistics.maxFrame = std::max(_frameStatistics.maxFrame, duration);
+            _frameStatistics.totalFrame += duration;
+            if (cutShort) {
+                _frameStatistics.cutShort++;
+            }
+            if (duration > frameBudget.budget + frameBudget.overrunTolerance) {
+                _frameStatistics.overruns++;
+                _frameStatistics.totalOverrun += duration - frameBudget.budget;
+            }
+        }
 
       private:
         std::thread::id _threadId;
@@ -247,10 +1063,15 @@ namespace bdn
         const bool _slave;
 
         std::mutex _queueMutex;
-        std::queue<Function> _queue;
-        std::map<TimePoint, std::queue<Function>> _timedQueue;
+        std::array<Lane, NumberOfPriorities> _lanes;
+        std::vector<std::pair<const void *, Function>> _frameEndFunctions;
+        std::unordered_map<const void *, CoalescedFunction> _coalescedFunctions;
+        FrameStatistics _frameStatistics;
+        TimerWheel<TimedFunction> _timers;
         std::condition_variable _notification;
         int _nTimed = 0;
-        bool _cancelled = false;
+        std::atomic<bool> _cancelled{false};
+        std::atomic<bool> _wakeUpPending{false};
+        SyncTask *_syncTasks = nullptr;
     };
 }
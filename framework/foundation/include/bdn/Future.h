@@ -0,0 +1,641 @@
+#pragma once
+
+#include <bdn/UniqueFunction.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace bdn
+{
+    template <class T> class Future;
+    template <class T> class Promise;
+
+    /** Set as the exception of futures whose continuation was cancelled */
+    class CancelledException : public std::runtime_error
+    {
+      public:
+        CancelledException() : std::runtime_error("The operation was cancelled") {}
+    };
+
+    namespace detail
+    {
+        struct CancellationState
+        {
+            std::mutex mutex;
+            std::atomic<bool> cancelled{false};
+            std::vector<UniqueFunction<void()>> callbacks;
+        };
+    }
+
+    /** Observes a CancellationSource. A default constructed token is never
+        cancelled. */
+    class CancellationToken
+    {
+      public:
+        CancellationToken() = default;
+
+        bool isCancelled() const { return _state && _state->cancelled; }
+
+        void throwIfCancelled() const
+        {
+            if (isCancelled()) {
+                throw CancelledException();
+            }
+        }
+
+        /** Calls callback on the thread that cancels the source, or right away
+            if it is already cancelled. */
+        void onCancel(UniqueFunction<void()> callback) const
+        {
+            if (!_state) {
+                return;
+            }
+
+            std::unique_lock<std::mutex> lk(_state->mutex);
+            if (!_state->cancelled) {
+                _state->callbacks.push_back(std::move(callback));
+                return;
+            }
+            lk.unlock();
+            callback();
+        }
+
+      private:
+        friend class CancellationSource;
+        CancellationToken(std::shared_ptr<detail::CancellationState> state) : _state(std::move(state)) {}
+
+        std::shared_ptr<detail::CancellationState> _state;
+    };
+
+    class CancellationSource
+    {
+      public:
+        CancellationSource() : _state(std::make_shared<detail::CancellationState>()) {}
+
+        CancellationToken token() const { return CancellationToken(_state); }
+
+        bool isCancelled() const { return _state->cancelled; }
+
+        void cancel()
+        {
+            std::vector<UniqueFunction<void()>> callbacks;
+            {
+                std::unique_lock<std::mutex> lk(_state->mutex);
+                if (_state->cancelled.exchange(true)) {
+                    return;
+                }
+                callbacks = std::move(_state->callbacks);
+            }
+
+            for (auto &callback : callbacks) {
+                callback();
+            }
+        }
+
+      private:
+        std::shared_ptr<detail::CancellationState> _state;
+    };
+
+    namespace detail
+    {
+        template <class T> using FutureStorage = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+        /** Shared by a Promise and its Future. Holds the result and at most one
+            continuation, which is called by whoever completes the state. */
+        template <class T> class FutureState
+        {
+          public:
+            using Storage = FutureStorage<T>;
+
+            void setValue(Storage value)
+            {
+                std::unique_lock<std::mutex> lk(_mutex);
+                if (_ready) {
+                    throw std::future_error(std::future_errc::promise_already_satisfied);
+                }
+                _value.emplace(std::move(value));
+                complete(lk);
+            }
+
+            void setException(std::exception_ptr exception)
+            {
+                std::unique_lock<std::mutex> lk(_mutex);
+                if (_ready) {
+                    throw std::future_error(std::future_errc::promise_already_satisfied);
+                }
+                _exception = std::move(exception);
+                complete(lk);
+            }
+
+            bool isReady()
+            {
+                std::unique_lock<std::mutex> lk(_mutex);
+                return _ready;
+            }
+
+            void wait()
+            {
+                std::unique_lock<std::mutex> lk(_mutex);
+                _readyCondition.wait(lk, [this]() { return _ready; });
+            }
+
+            /** Calls continuation once the state is ready, right away if it
+                already is */
+            void onReady(UniqueFunction<void()> continuation)
+            {
+                if (!tryOnReady(continuation)) {
+                    continuation();
+                }
+            }
+
+            /** Stores continuation unless the state is already ready. Returns
+                false (and leaves continuation alone) if it is. */
+            bool tryOnReady(UniqueFunction<void()> &continuation)
+            {
+                std::unique_lock<std::mutex> lk(_mutex);
+                if (_ready) {
+                    return false;
+                }
+                _continuation = std::move(continuation);
+                return true;
+            }
+
+            /** Only valid once the state is ready */
+            std::exception_ptr exception() const { return _exception; }
+            Storage takeValue() { return std::move(*_value); }
+
+          private:
+            void complete(std::unique_lock<std::mutex> &lk)
+            {
+                _ready = true;
+                auto continuation = std::move(_continuation);
+                _continuation = nullptr;
+                _readyCondition.notify_all();
+                lk.unlock();
+
+                if (continuation) {
+                    continuation();
+                }
+            }
+
+          private:
+            std::mutex _mutex;
+            std::condition_variable _readyCondition;
+            bool _ready = false;
+            std::optional<Storage> _value;
+            std::exception_ptr _exception;
+            UniqueFunction<void()> _continuation;
+        };
+
+        template <class T> struct IsFuture : std::false_type
+        {
+        };
+        template <class T> struct IsFuture<Future<T>> : std::true_type
+        {
+        };
+
+        template <class T> struct UnwrapFuture
+        {
+            using type = T;
+        };
+        template <class T> struct UnwrapFuture<Future<T>>
+        {
+            using type = T;
+        };
+
+        template <class T, class F> struct ContinuationResult
+        {
+            using type = std::invoke_result_t<F, T>;
+        };
+        template <class F> struct ContinuationResult<void, F>
+        {
+            using type = std::invoke_result_t<F>;
+        };
+
+        /** Calls function with the value of state and fulfills promise with its
+            result. If function returns a Future, promise is fulfilled once that
+            future is ready. */
+        template <class T, class R, class F>
+        void runContinuation(FutureState<T> &state, F &function, Promise<R> &promise);
+
+        template <class T> class FutureAwaiter;
+    }
+
+    /** The receiving end of an asynchronous result.
+
+        A Future is move-only and has at most one consumer: either get() or
+        then() may be called once, afterwards the future is no longer valid.
+     */
+    template <class T> class Future
+    {
+      public:
+        using ValueType = T;
+
+        Future() = default;
+        Future(Future &&) noexcept = default;
+        Future &operator=(Future &&) noexcept = default;
+        Future(const Future &) = delete;
+        Future &operator=(const Future &) = delete;
+
+        bool valid() const { return _state != nullptr; }
+        bool isReady() const { return _state && _state->isReady(); }
+
+        void wait() const { _state->wait(); }
+
+        /** Blocks until the result is available and returns it, or rethrows
+            the exception it was completed with. Must not be called on the
+            thread of a queue that is supposed to complete the future. */
+        T get()
+        {
+            auto state = std::move(_state);
+            state->wait();
+            if (auto exception = state->exception()) {
+                std::rethrow_exception(exception);
+            }
+            if constexpr (!std::is_void_v<T>) {
+                return state->takeValue();
+            }
+        }
+
+        /** Dispatches function to queue once the result is available.
+
+            function is called with the value of this future (or without
+            arguments for Future<void>) and the returned future is completed
+            with its result. If function returns a Future, the returned future
+            is completed once that one is. If this future fails, or if token
+            has been cancelled by the time the continuation runs, function is
+            not called and the returned future fails with the same exception
+            or a CancelledException respectively.
+
+            queue can be a DispatchQueue or a ConcurrentDispatchQueue. No
+            thread is blocked while waiting for the result.
+         */
+        template <class Queue, class F>
+        auto then(std::shared_ptr<Queue> queue, F function, CancellationToken token = CancellationToken())
+        {
+            using R = typename detail::UnwrapFuture<typename detail::ContinuationResult<T, F>::type>::type;
+
+            Promise<R> promise;
+            auto result = promise.future();
+
+            auto state = std::move(_state);
+            auto statePointer = state.get();
+            statePointer->onReady([queue = std::move(queue), state = std::move(state), function = std::move(function),
+                                   promise = std::move(promise), token = std::move(token)]() mutable {
+                queue->dispatchAsync([state = std::move(state), function = std::move(function),
+                                      promise = std::move(promise), token = std::move(token)]() mutable {
+                    if (token.isCancelled()) {
+                        promise.setException(std::make_exception_ptr(CancelledException()));
+                        return;
+                    }
+                    detail::runContinuation(*state, function, promise);
+                });
+            });
+
+            return result;
+        }
+
+      private:
+        friend class Promise<T>;
+        template <class U, class R, class F>
+        friend void detail::runContinuation(detail::FutureState<U> &, F &, Promise<R> &);
+        template <class U> friend class Future;
+        friend class detail::FutureAwaiter<T>;
+        template <class U> friend Future<std::vector<U>> whenAll(std::vector<Future<U>> futures);
+        friend Future<void> whenAll(std::vector<Future<void>> futures);
+        template <class U> friend Future<std::pair<size_t, U>> whenAny(std::vector<Future<U>> futures);
+        friend Future<size_t> whenAny(std::vector<Future<void>> futures);
+
+        Future(std::shared_ptr<detail::FutureState<T>> state) : _state(std::move(state)) {}
+
+        std::shared_ptr<detail::FutureState<T>> _state;
+    };
+
+    /** The sending end of an asynchronous result. A promise that is destroyed
+        without a result completes its future with a broken_promise
+        std::future_error. */
+    template <class T> class Promise
+    {
+      public:
+        Promise() : _state(std::make_shared<detail::FutureState<T>>()) {}
+        Promise(Promise &&other) noexcept
+            : _state(std::move(other._state)), _futureRetrieved(other._futureRetrieved), _satisfied(other._satisfied)
+        {}
+        Promise &operator=(Promise &&other) noexcept
+        {
+            abandon();
+            _state = std::move(other._state);
+            _futureRetrieved = other._futureRetrieved;
+            _satisfied = other._satisfied;
+            return *this;
+        }
+        ~Promise() { abandon(); }
+
+        Future<T> future()
+        {
+            if (!_state) {
+                throw std::future_error(std::future_errc::no_state);
+            }
+            if (_futureRetrieved) {
+                throw std::future_error(std::future_errc::future_already_retrieved);
+            }
+            _futureRetrieved = true;
+            return Future<T>(_state);
+        }
+
+        template <class... Arguments> void setValue(Arguments &&... arguments)
+        {
+            satisfy().setValue(detail::FutureStorage<T>(std::forward<Arguments>(arguments)...));
+        }
+
+        void setException(std::exception_ptr exception) { satisfy().setException(std::move(exception)); }
+
+      private:
+        detail::FutureState<T> &satisfy()
+        {
+            if (!_state) {
+                throw std::future_error(std::future_errc::no_state);
+            }
+            if (_satisfied) {
+                throw std::future_error(std::future_errc::promise_already_satisfied);
+            }
+            _satisfied = true;
+            return *_state;
+        }
+
+        void abandon()
+        {
+            if (_state && !_satisfied) {
+                satisfy().setException(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+            }
+        }
+
+        std::shared_ptr<detail::FutureState<T>> _state;
+        bool _futureRetrieved = false;
+        bool _satisfied = false;
+    };
+
+    template <class T> Future<std::decay_t<T>> makeReadyFuture(T &&value)
+    {
+        Promise<std::decay_t<T>> promise;
+        promise.setValue(std::forward<T>(value));
+        return promise.future();
+    }
+
+    inline Future<void> makeReadyFuture()
+    {
+        Promise<void> promise;
+        promise.setValue();
+        return promise.future();
+    }
+
+    template <class T> Future<T> makeExceptionalFuture(std::exception_ptr exception)
+    {
+        Promise<T> promise;
+        promise.setException(std::move(exception));
+        return promise.future();
+    }
+
+    /** Runs function on queue and returns a future for its result */
+    template <class Queue, class F>
+    auto dispatchFuture(std::shared_ptr<Queue> queue, F function, CancellationToken token = CancellationToken())
+    {
+        return makeReadyFuture().then(std::move(queue), std::move(function), std::move(token));
+    }
+
+    /** Completes once all futures have completed successfully, or as soon as
+        the first of them fails. The values are in the order of futures. */
+    template <class T> Future<std::vector<T>> whenAll(std::vector<Future<T>> futures)
+    {
+        struct Join
+        {
+            std::mutex mutex;
+            std::vector<std::optional<T>> values;
+            size_t remaining;
+            Promise<std::vector<T>> promise;
+            bool done = false;
+        };
+
+        auto join = std::make_shared<Join>();
+        join->values.resize(futures.size());
+        join->remaining = futures.size();
+        auto result = join->promise.future();
+
+        if (futures.empty()) {
+            join->promise.setValue();
+            return result;
+        }
+
+        for (size_t i = 0; i < futures.size(); i++) {
+            auto state = std::move(futures[i]._state);
+            auto statePointer = state.get();
+            statePointer->onReady([join, state = std::move(state), i]() {
+                std::unique_lock<std::mutex> lk(join->mutex);
+                if (join->done) {
+                    return;
+                }
+
+                if (auto exception = state->exception()) {
+                    join->done = true;
+                    lk.unlock();
+                    join->promise.setException(exception);
+                    return;
+                }
+
+                join->values[i].emplace(state->takeValue());
+                if (--join->remaining == 0) {
+                    join->done = true;
+                    std::vector<T> values;
+                    values.reserve(join->values.size());
+                    for (auto &value : join->values) {
+                        values.push_back(std::move(*value));
+                    }
+                    lk.unlock();
+                    join->promise.setValue(std::move(values));
+                }
+            });
+        }
+
+        return result;
+    }
+
+    inline Future<void> whenAll(std::vector<Future<void>> futures)
+    {
+        struct Join
+        {
+            std::mutex mutex;
+            size_t remaining;
+            Promise<void> promise;
+            bool done = false;
+        };
+
+        auto join = std::make_shared<Join>();
+        join->remaining = futures.size();
+        auto result = join->promise.future();
+
+        if (futures.empty()) {
+            join->promise.setValue();
+            return result;
+        }
+
+        for (auto &future : futures) {
+            auto state = std::move(future._state);
+            auto statePointer = state.get();
+            statePointer->onReady([join, state = std::move(state)]() {
+                std::unique_lock<std::mutex> lk(join->mutex);
+                if (join->done) {
+                    return;
+                }
+
+                auto exception = state->exception();
+                if (exception || --join->remaining == 0) {
+                    join->done = true;
+                    lk.unlock();
+                    if (exception) {
+                        join->promise.setException(exception);
+                    } else {
+                        join->promise.setValue();
+                    }
+                }
+            });
+        }
+
+        return result;
+    }
+
+    /** Completes with the index and result of the first of futures that
+        completes. If that one failed, the returned future fails as well. */
+    template <class T> Future<std::pair<size_t, T>> whenAny(std::vector<Future<T>> futures)
+    {
+        if (futures.empty()) {
+            throw std::invalid_argument("whenAny needs at least one future");
+        }
+
+        struct Race
+        {
+            std::atomic<bool> done{false};
+            Promise<std::pair<size_t, T>> promise;
+        };
+
+        auto race = std::make_shared<Race>();
+        auto result = race->promise.future();
+
+        for (size_t i = 0; i < futures.size(); i++) {
+            auto state = std::move(futures[i]._state);
+            auto statePointer = state.get();
+            statePointer->onReady([race, state = std::move(state), i]() {
+                if (race->done.exchange(true)) {
+                    return;
+                }
+                if (auto exception = state->exception()) {
+                    race->promise.setException(exception);
+                } else {
+                    race->promise.setValue(std::make_pair(i, state->takeValue()));
+                }
+            });
+        }
+
+        return result;
+    }
+
+    /** Completes with the index of the first of futures that completes */
+    inline Future<size_t> whenAny(std::vector<Future<void>> futures)
+    {
+        if (futures.empty()) {
+            throw std::invalid_argument("whenAny needs at least one future");
+        }
+
+        struct Race
+        {
+            std::atomic<bool> done{false};
+            Promise<size_t> promise;
+        };
+
+        auto race = std::make_shared<Race>();
+        auto result = race->promise.future();
+
+        for (size_t i = 0; i < futures.size(); i++) {
+            auto state = std::move(futures[i]._state);
+            auto statePointer = state.get();
+            statePointer->onReady([race, state = std::move(state), i]() {
+                if (race->done.exchange(true)) {
+                    return;
+                }
+                if (auto exception = state->exception()) {
+                    race->promise.setException(exception);
+                } else {
+                    race->promise.setValue(i);
+                }
+            });
+        }
+
+        return result;
+    }
+
+    namespace detail
+    {
+        template <class T, class R, class F>
+        void runContinuation(FutureState<T> &state, F &function, Promise<R> &promise)
+        {
+            if (auto exception = state.exception()) {
+                promise.setException(exception);
+                return;
+            }
+
+            auto call = [&]() -> decltype(auto) {
+                if constexpr (std::is_void_v<T>) {
+                    return function();
+                } else {
+                    return function(state.takeValue());
+                }
+            };
+
+            using Result = typename ContinuationResult<T, F>::type;
+
+            if constexpr (IsFuture<Result>::value) {
+                Result inner;
+                try {
+                    inner = call();
+                }
+                catch (...) {
+                    promise.setException(std::current_exception());
+                    return;
+                }
+
+                auto innerState = std::move(inner._state);
+                auto innerPointer = innerState.get();
+                innerPointer->onReady([innerState = std::move(innerState), promise = std::move(promise)]() mutable {
+                    if (auto exception = innerState->exception()) {
+                        promise.setException(exception);
+                    } else if constexpr (std::is_void_v<R>) {
+                        promise.setValue();
+                    } else {
+                        promise.setValue(innerState->takeValue());
+                    }
+                });
+            } else {
+                try {
+                    if constexpr (std::is_void_v<Result>) {
+                        call();
+                        promise.setValue();
+                    } else {
+                        promise.setValue(call());
+                    }
+                }
+                catch (...) {
+                    promise.setException(std::current_exception());
+                }
+            }
+        }
+    }
+}
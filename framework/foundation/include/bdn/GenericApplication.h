@@ -2,6 +2,7 @@
 
 #include <bdn/Application.h>
 
+#include <optional>
 #include <utility>
 
 namespace bdn
@@ -70,6 +71,11 @@ namespace bdn
 
         void openURL(const std::string &url) override {}
 
+        /** Makes the main loop process the dispatch queue in frames (see
+            DispatchQueue::enterFrameLoop()). Must be called before entry(),
+            std::nullopt switches back to processing everything at once. */
+        void setFrameBudget(std::optional<DispatchQueue::FrameBudget> frameBudget) { _frameBudget = frameBudget; }
+
         void copyToClipboard(const std::string &str) override {}
 
       protected:
@@ -79,11 +85,19 @@ namespace bdn
             return _exitRequested;
         }
 
-        void mainLoop() { dispatchQueue()->enter(); }
+        void mainLoop()
+        {
+            if (_frameBudget) {
+                dispatchQueue()->enterFrameLoop(*_frameBudget);
+            } else {
+                dispatchQueue()->enter();
+            }
+        }
 
         void disposeMainDispatcher() override {}
 
         bool _commandLineApp;
+        std::optional<DispatchQueue::FrameBudget> _frameBudget;
 
         mutable std::recursive_mutex _exitMutex;
 
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace bdn
+{
+    template <class... Arguments> class Notifier;
+
+    /** Collects statistics about Notifier::notify() calls and property sets
+        to find the properties that dominate the notification cost.
+
+        Profiling is off by default and costs a single atomic load per
+        notification then. Sources are identified by the address of their
+        notifier, optionally named with setName(). Property values are
+        recorded with their value type, other notifiers with the notifier
+        type.
+     */
+    class NotificationProfiler
+    {
+      public:
+        struct Entry
+        {
+            const void *source = nullptr;
+            std::string name;
+            std::string type;
+
+            size_t notifications = 0;
+            /** Sum of the subscribers called by all notifications */
+            size_t subscriberCalls = 0;
+            size_t maxSubscribers = 0;
+            /** Time spent in the subscribers, including nested notifications */
+            std::chrono::nanoseconds callbackTime{};
+
+            size_t sets = 0;
+            /** Sets with a value equal to the current one */
+            size_t redundantSets = 0;
+        };
+
+      public:
+        static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+        static void setEnabled(bool enabled);
+
+        /** Discards all statistics collected so far */
+        static void reset();
+
+        template <class... Arguments> static void setName(const Notifier<Arguments...> &notifier, std::string name)
+        {
+            setName(static_cast<const void *>(&notifier), std::move(name));
+        }
+        static void setName(const void *source, std::string name);
+
+        static void recordNotify(const void *source, const std::type_info &type, size_t subscribers,
+                                 std::chrono::nanoseconds callbackTime);
+        static void recordSet(const void *source, const std::type_info &type, bool redundant);
+
+        /** Returns the statistics of all sources, the most expensive first */
+        static std::vector<Entry> entries();
+
+        /** Returns entries() as a JSON array */
+        static std::string toJson();
+
+        /** Returns a human readable table of the count most expensive
+            sources. Application logs it on termination if profiling is
+            enabled. */
+        static std::string report(size_t count = 10);
+
+      private:
+        static inline std::atomic<bool> s_enabled{false};
+    };
+}
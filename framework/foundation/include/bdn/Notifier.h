@@ -1,158 +1,626 @@
 #pragma once
 
+#include <bdn/NotificationProfiler.h>
+
+#include <chrono>
+#include <cstdint>
 #include <functional>
-#include <list>
-#include <map>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
 
 namespace bdn
 {
-    struct _Subscription
+    /** Identifies a subscription to a Notifier.
+
+        Subscription ids are unique across all notifiers, so a subscription
+        stays valid when it is taken over by another notifier. A default
+        constructed subscription does not refer to anything and can safely
+        be passed to Notifier::unsubscribe().
+     */
+    class NotifierSubscription
     {
       public:
-        size_t order;
+        NotifierSubscription() = default;
+
+        explicit operator bool() const { return _id != 0; }
+
+        bool operator==(const NotifierSubscription &other) const { return _id == other._id; }
+        bool operator!=(const NotifierSubscription &other) const { return _id != other._id; }
+        bool operator<(const NotifierSubscription &other) const { return _id < other._id; }
+
+      private:
+        explicit NotifierSubscription(uint64_t id) : _id(id) {}
+
+        static uint64_t nextId();
+
+        template <class... Arguments> friend class Notifier;
+
+      private:
+        uint64_t _id = 0;
     };
-}
 
-namespace std
-{
-    template <> struct less<std::shared_ptr<bdn::_Subscription>>
+    class NotifierConnection;
+
+    namespace detail
+    {
+        /** The connections of a notifier. Base of the notifier's storage, so
+            that connections do not depend on the notifier's arguments. */
+        struct NotifierConnectionList
+        {
+            using Disconnect = void (*)(NotifierConnectionList &list, NotifierSubscription subscription);
+
+            explicit NotifierConnectionList(Disconnect disconnect) : disconnect(disconnect) {}
+            NotifierConnectionList(const NotifierConnectionList &) = delete;
+            NotifierConnectionList &operator=(const NotifierConnectionList &) = delete;
+            ~NotifierConnectionList() { detachAll(); }
+
+            /** Disconnects all connections without touching the slots */
+            inline void detachAll();
+            inline void add(NotifierConnection &connection);
+            inline void takeOver(NotifierConnectionList &other);
+
+            Disconnect disconnect;
+            NotifierConnection *first = nullptr;
+        };
+    }
+
+    /** A subscription that is removed when the connection is destroyed.
+
+        Meant to be stored as a member of the subscriber, so that it cannot
+        outlive it. Connections are linked into the notifier's storage
+        instead of holding a reference to it: destroying the notifier first
+        just disconnects them. Like the Notifier itself, connections are not
+        thread safe.
+     */
+    class NotifierConnection
     {
-        bool operator()(const std::shared_ptr<bdn::_Subscription> &k1,
-                        const std::shared_ptr<bdn::_Subscription> &k2) const
+      public:
+        NotifierConnection() = default;
+        NotifierConnection(const NotifierConnection &) = delete;
+        NotifierConnection(NotifierConnection &&other) noexcept { takeOver(other); }
+        ~NotifierConnection() { disconnect(); }
+
+        NotifierConnection &operator=(const NotifierConnection &) = delete;
+        NotifierConnection &operator=(NotifierConnection &&other) noexcept
+        {
+            if (this != &other) {
+                disconnect();
+                takeOver(other);
+            }
+            return *this;
+        }
+
+        bool isConnected() const { return _list != nullptr; }
+        explicit operator bool() const { return isConnected(); }
+
+        /** Removes the subscription, if the notifier still exists */
+        void disconnect()
+        {
+            if (auto list = _list) {
+                unlink();
+                list->disconnect(*list, _subscription);
+            }
+        }
+
+      private:
+        NotifierConnection(detail::NotifierConnectionList &list, NotifierSubscription subscription)
+            : _subscription(subscription)
+        {
+            list.add(*this);
+        }
+
+        void unlink()
         {
-            return k1->order < k2->order;
+            if (_prev != nullptr) {
+                _prev->_next = _next;
+            } else {
+                _list->first = _next;
+            }
+            if (_next != nullptr) {
+                _next->_prev = _prev;
+            }
+            _list = nullptr;
+            _prev = _next = nullptr;
+        }
+
+        void takeOver(NotifierConnection &other)
+        {
+            _list = std::exchange(other._list, nullptr);
+            _subscription = other._subscription;
+            _prev = std::exchange(other._prev, nullptr);
+            _next = std::exchange(other._next, nullptr);
+
+            if (_list == nullptr) {
+                return;
+            }
+            if (_prev != nullptr) {
+                _prev->_next = this;
+            } else {
+                _list->first = this;
+            }
+            if (_next != nullptr) {
+                _next->_prev = this;
+            }
         }
+
+        friend struct detail::NotifierConnectionList;
+        template <class... Arguments> friend class Notifier;
+
+      private:
+        detail::NotifierConnectionList *_list = nullptr;
+        NotifierSubscription _subscription;
+        NotifierConnection *_prev = nullptr;
+        NotifierConnection *_next = nullptr;
     };
-}
 
-namespace bdn
-{
+    namespace detail
+    {
+        void NotifierConnectionList::detachAll()
+        {
+            while (first != nullptr) {
+                first->unlink();
+            }
+        }
+
+        void NotifierConnectionList::add(NotifierConnection &connection)
+        {
+            connection._list = this;
+            connection._prev = nullptr;
+            connection._next = first;
+            if (first != nullptr) {
+                first->_prev = &connection;
+            }
+            first = &connection;
+        }
+
+        void NotifierConnectionList::takeOver(NotifierConnectionList &other)
+        {
+            while (auto connection = other.first) {
+                connection->unlink();
+                add(*connection);
+            }
+        }
+
+        /** A growable array whose elements never move when it grows.
+
+            Element i lives in chunk floor(log2(i + 1)) and chunk k holds 2^k
+            elements, so a handful of small allocations cover any size and
+            references to elements stay valid while elements are appended.
+            Chunk 0, the first element, is stored inline.
+         */
+        template <class T> class StableSlots
+        {
+          public:
+            StableSlots() = default;
+            StableSlots(const StableSlots &other)
+            {
+                for (size_t i = 0; i < other.size(); i++) {
+                    push_back(other[i]);
+                }
+            }
+            StableSlots(StableSlots &&other) noexcept
+                : _first(std::move(other._first)), _chunks(std::move(other._chunks)),
+                  _size(std::exchange(other._size, 0))
+            {}
+
+            StableSlots &operator=(StableSlots other) noexcept
+            {
+                swap(other);
+                return *this;
+            }
+
+            size_t size() const { return _size; }
+            bool empty() const { return _size == 0; }
 
+            T &operator[](size_t index)
+            {
+                if (index == 0) {
+                    return _first;
+                }
+                size_t chunk = chunkOf(index);
+                return _chunks[chunk - 1][index + 1 - (size_t(1) << chunk)];
+            }
+            const T &operator[](size_t index) const { return const_cast<StableSlots &>(*this)[index]; }
+
+            void push_back(T value)
+            {
+                if (_size > 0) {
+                    size_t chunk = chunkOf(_size);
+                    if (chunk > _chunks.size()) {
+                        _chunks.push_back(std::make_unique<T[]>(size_t(1) << chunk));
+                    }
+                }
+                (*this)[_size] = std::move(value);
+                _size++;
+            }
+
+            /** Resets the elements from newSize on and frees the chunks
+                that are no longer needed. */
+            void truncate(size_t newSize)
+            {
+                for (size_t i = newSize; i < _size; i++) {
+                    (*this)[i] = T();
+                }
+                _size = newSize;
+
+                _chunks.resize(newSize <= 1 ? 0 : chunkOf(newSize - 1));
+            }
+
+            void swap(StableSlots &other) noexcept
+            {
+                std::swap(_first, other._first);
+                std::swap(_chunks, other._chunks);
+                std::swap(_size, other._size);
+            }
+
+          private:
+            static size_t chunkOf(size_t index)
+            {
+                size_t n = index + 1;
+                size_t chunk = 0;
+                while (n >>= 1) {
+                    chunk++;
+                }
+                return chunk;
+            }
+
+          private:
+            T _first{};
+            std::vector<std::unique_ptr<T[]>> _chunks;
+            size_t _size = 0;
+        };
+    }
+
+    /** Notifies subscribers synchronously.
+
+        Subscribers are kept in subscription order in flat slot storage.
+        Unsubscribing during notify() only marks the slot as dead, dead
+        slots are compacted once no notification is running. Subscribers
+        added during notify() are called by the running notification.
+
+        The storage is only allocated by the first subscribe() call, a
+        notifier that never had a subscriber is a single null pointer.
+     */
     template <class... Arguments> class Notifier
     {
       public:
-        using Subscription = std::shared_ptr<_Subscription>;
+        using Subscription = NotifierSubscription;
         using Target = std::function<void(Arguments...)>;
 
       private:
-        using SubscriptionMap = std::map<Subscription, Target>;
-        using NotificationRun = typename SubscriptionMap::iterator;
+        struct Slot
+        {
+            uint64_t id = 0;
+            bool alive = false;
+            Target target;
+        };
+
+        struct State : detail::NotifierConnectionList
+        {
+            State() : NotifierConnectionList(&Notifier::disconnectSlot) {}
+            // Targets destroyed with the slots must not reach this state
+            // through a connection anymore.
+            ~State() { detachAll(); }
+
+            detail::StableSlots<Slot> slots;
+            size_t deadSlots = 0;
+            bool sortedById = true;
+            unsigned notifyDepth = 0;
+            uint64_t generation = 0;
+        };
+
+        static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+      public:
+        Notifier() = default;
+        Notifier(const Notifier &other)
+        {
+            if (other._state) {
+                _state = std::make_unique<State>();
+                _state->slots = other._state->slots;
+                _state->deadSlots = other._state->deadSlots;
+                _state->sortedById = other._state->sortedById;
+            }
+        }
+        Notifier &operator=(const Notifier &other)
+        {
+            Notifier copy(other);
+            swap(copy);
+            return *this;
+        }
 
       public:
         Subscription subscribe(Target target)
         {
-            Subscription nextSubscription = createSubscription();
+            if (!_state) {
+                _state = std::make_unique<State>();
+            }
 
-            _subscriptions.insert(_subscriptions.end(), std::make_pair(nextSubscription, target));
-            return nextSubscription;
+            Subscription subscription(Subscription::nextId());
+            _state->slots.push_back(Slot{subscription._id, true, std::move(target)});
+            return subscription;
+        }
+
+        /** Like subscribe(), but the subscription is removed when the
+            returned connection is destroyed. */
+        NotifierConnection connect(Target target)
+        {
+            auto subscription = subscribe(std::move(target));
+            return NotifierConnection(*_state, subscription);
         }
 
         void unsubscribe(Subscription subscription)
         {
-            auto it = _subscriptions.find(subscription);
-            if (it != _subscriptions.end()) {
-                for (auto itRunning = _notificationRuns.begin(); itRunning != _notificationRuns.end(); itRunning++) {
-                    if (*itRunning == it) {
-                        (*itRunning)++;
-                    }
-                }
-                _subscriptions.erase(it);
+            if (!_state) {
+                return;
+            }
+
+            auto &state = *_state;
+            // Destroy the target only after the storage is consistent
+            // again, its destructor may call back into the notifier.
+            Target target;
+            if (!removeSlot(state, subscription, target)) {
+                return;
+            }
+
+            if (state.notifyDepth == 0 && state.slots.empty()) {
+                auto released = std::move(_state);
             }
         }
 
         void unsubscribeAll()
         {
-            _subscriptions.clear();
-            for (auto itRunning = _notificationRuns.begin(); itRunning != _notificationRuns.end(); itRunning++) {
-                (*itRunning) = _subscriptions.end();
+            if (!_state) {
+                return;
+            }
+
+            auto &state = *_state;
+            state.generation++;
+
+            if (state.notifyDepth == 0) {
+                auto released = std::move(_state);
+                return;
+            }
+
+            for (size_t i = 0; i < state.slots.size(); i++) {
+                if (state.slots[i].alive) {
+                    state.slots[i].alive = false;
+                    state.deadSlots++;
+                }
             }
         }
 
-        Notifier<Arguments...> operator+=(Target target)
+        Notifier<Arguments...> &operator+=(Target target)
         {
-            subscribe(target);
+            subscribe(std::move(target));
             return *this;
         }
 
-        void swap(Notifier<Arguments...> &other) { std::swap(_subscriptions, other._subscriptions); }
+        void swap(Notifier<Arguments...> &other) { std::swap(_state, other._state); }
+
+        void takeOverSubscriptions(Notifier<Arguments...> &other) { takeOverSlots(other); }
+
+        void takeOverSubscriptionsAndNotify(Notifier<Arguments...> &other, Arguments... arguments)
+        {
+            size_t firstNew = takeOverSlots(other);
+            if (_state && firstNew < _state->slots.size()) {
+                notifyFrom(*_state, firstNew, arguments...);
+            }
+        }
 
-        void takeOverSubscriptions(Notifier<Arguments...> &other)
+      public:
+        void notify(Arguments... arguments)
         {
-            if (other._subscriptions.empty()) {
+            if (!_state || _state->slots.empty()) {
                 return;
             }
 
-            _takeOverSubscriptions(other);
+            if (NotificationProfiler::isEnabled()) {
+                notifyProfiled(arguments...);
+                return;
+            }
+
+            notifyFrom(*_state, 0, arguments...);
         }
 
-        void takeOverSubscriptionsAndNotify(Notifier<Arguments...> &other, Arguments... arguments)
+      private:
+        class NotifyScope
         {
-            if (other._subscriptions.empty()) {
-                return;
+          public:
+            explicit NotifyScope(State &state) : _state(state) { _state.notifyDepth++; }
+            ~NotifyScope()
+            {
+                if (--_state.notifyDepth == 0 && _state.deadSlots > 0) {
+                    compact(_state);
+                }
             }
 
-            auto firstNew = _takeOverSubscriptions(other);
+          private:
+            State &_state;
+        };
+
+        static void notifyFrom(State &state, size_t index, Arguments... arguments)
+        {
+            // The state is not released while a notification is running, see
+            // unsubscribeAll()
+            NotifyScope scope(state);
+
+            // unsubscribeAll() ends the run, even if new subscribers are
+            // added afterwards.
+            auto generation = state.generation;
 
-            notifyFrom(firstNew, arguments...);
+            for (; index < state.slots.size() && generation == state.generation; index++) {
+                auto &slot = state.slots[index];
+                if (slot.alive) {
+                    slot.target(arguments...);
+                }
+            }
         }
 
-        typename SubscriptionMap::iterator _takeOverSubscriptions(Notifier<Arguments...> &other)
+        void notifyProfiled(Arguments... arguments)
         {
-            auto otherSubs = other._subscriptions;
-            other.unsubscribeAll();
+            // Subscribers may destroy this notifier, its address is only
+            // used as a key afterwards.
+            const void *source = this;
+            size_t subscribers = _state->slots.size() - _state->deadSlots;
+
+            auto start = std::chrono::steady_clock::now();
+            notifyFrom(*_state, 0, arguments...);
+            auto callbackTime = std::chrono::steady_clock::now() - start;
+
+            NotificationProfiler::recordNotify(source, typeid(Notifier<Arguments...>), subscribers,
+                                               std::chrono::duration_cast<std::chrono::nanoseconds>(callbackTime));
+        }
+
+        size_t takeOverSlots(Notifier<Arguments...> &other)
+        {
+            if (!other._state) {
+                return _state ? _state->slots.size() : 0;
+            }
+
+            if (!_state) {
+                _state = std::make_unique<State>();
+            }
+
+            auto &state = *_state;
+            auto &otherState = *other._state;
+            size_t firstNew = state.slots.size();
+
+            for (size_t i = 0; i < otherState.slots.size(); i++) {
+                auto &slot = otherState.slots[i];
+                if (!slot.alive) {
+                    continue;
+                }
 
-            auto firstNew = _subscriptions.end();
+                if (!state.slots.empty() && state.slots[state.slots.size() - 1].id > slot.id) {
+                    state.sortedById = false;
+                }
 
-            for (auto sub : otherSubs) {
-                sub.first->order = nextId();
-                auto newIt = _subscriptions.insert(_subscriptions.end(), sub);
-                if (firstNew == _subscriptions.end()) {
-                    firstNew = newIt;
+                // The other notifier may be running and still need the target
+                if (otherState.notifyDepth > 0) {
+                    state.slots.push_back(slot);
+                } else {
+                    state.slots.push_back(Slot{slot.id, true, std::move(slot.target)});
                 }
             }
 
+            state.takeOver(otherState);
+            other.unsubscribeAll();
+
             return firstNew;
         }
 
-      public:
-        void notify(Arguments... arguments)
+        static bool removeSlot(State &state, Subscription subscription, Target &removedTarget)
         {
-            if (_subscriptions.empty()) {
-                return;
+            size_t index = find(state, subscription);
+            if (index == npos) {
+                return false;
             }
 
-            notifyFrom(_subscriptions.begin(), arguments...);
+            state.slots[index].alive = false;
+            state.deadSlots++;
+
+            if (state.notifyDepth == 0) {
+                removedTarget = std::move(state.slots[index].target);
+                compactIfWorthIt(state);
+            }
+            return true;
         }
 
-      private:
-        void notifyFrom(typename SubscriptionMap::iterator itStart, Arguments... arguments)
+        static void disconnectSlot(detail::NotifierConnectionList &list, Subscription subscription)
         {
-            auto itRun = _notificationRuns.insert(_notificationRuns.end(), itStart);
+            // The storage is kept even if this was the last subscriber, the
+            // connection cannot reach the notifier owning it.
+            Target target;
+            removeSlot(static_cast<State &>(list), subscription, target);
+        }
 
-            auto &notificationRun = *itRun;
-            auto it = notificationRun;
-            do {
-                notificationRun++;
-                it->second(arguments...);
-                it = notificationRun;
-            } while (it != _subscriptions.end());
+        static size_t find(const State &state, Subscription subscription)
+        {
+            if (!subscription) {
+                return npos;
+            }
 
-            _notificationRuns.erase(itRun);
+            const auto &slots = state.slots;
+
+            if (state.sortedById) {
+                size_t begin = 0;
+                size_t end = slots.size();
+                while (begin < end) {
+                    size_t middle = begin + (end - begin) / 2;
+                    if (slots[middle].id < subscription._id) {
+                        begin = middle + 1;
+                    } else {
+                        end = middle;
+                    }
+                }
+                if (begin < slots.size() && slots[begin].id == subscription._id && slots[begin].alive) {
+                    return begin;
+                }
+                return npos;
+            }
+
+            for (size_t i = 0; i < slots.size(); i++) {
+                if (slots[i].id == subscription._id && slots[i].alive) {
+                    return i;
+                }
+            }
+            return npos;
         }
 
-      private:
-        size_t nextId()
+        static void compactIfWorthIt(State &state)
         {
-            if (!_subscriptions.empty()) {
-                return _subscriptions.rbegin()->first->order + 1;
+            // Dropping trailing slots is free, otherwise compacting is
+            // deferred until half of the slots are dead to keep unsubscribe
+            // amortized constant.
+            while (!state.slots.empty() && !state.slots[state.slots.size() - 1].alive) {
+                state.slots.truncate(state.slots.size() - 1);
+                state.deadSlots--;
+            }
+
+            if (state.deadSlots > 0 && state.deadSlots * 2 >= state.slots.size()) {
+                compact(state);
             }
-            return 0;
         }
 
-        Subscription createSubscription() { return std::make_shared<_Subscription>(_Subscription{nextId()}); }
+        static void compact(State &state)
+        {
+            // Keep the removed targets alive until the storage is consistent
+            detail::StableSlots<Slot> removed;
+
+            auto &slots = state.slots;
+            size_t kept = 0;
+            for (size_t i = 0; i < slots.size(); i++) {
+                auto &slot = slots[i];
+                if (!slot.alive) {
+                    if (slot.target) {
+                        removed.push_back(std::move(slot));
+                    }
+                    continue;
+                }
+                if (kept != i) {
+                    slots[kept] = std::move(slot);
+                }
+                kept++;
+            }
+
+            slots.truncate(kept);
+            state.deadSlots = 0;
+
+            if (!state.sortedById) {
+                state.sortedById = true;
+                for (size_t i = 1; i < slots.size(); i++) {
+                    if (slots[i - 1].id > slots[i].id) {
+                        state.sortedById = false;
+                        break;
+                    }
+                }
+            }
+        }
 
       private:
-        SubscriptionMap _subscriptions;
-        std::list<NotificationRun> _notificationRuns;
+        std::unique_ptr<State> _state;
     };
 }
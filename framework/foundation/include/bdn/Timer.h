@@ -35,12 +35,9 @@ namespace bdn
         void stop();
         void restart();
 
-      public:
-        size_t currentId();
-
       private:
-        size_t _id = 0;
         std::shared_ptr<DispatchQueue> _dispatchQueue;
+        DispatchQueue::TimerHandle _handle;
         Notifier<> _triggered;
         std::shared_ptr<TimerImpl> _impl;
         bool _isRunning = false;
@@ -0,0 +1,490 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <vector>
+
+namespace bdn
+{
+    /** Hierarchical timer wheel with millisecond resolution.
+
+        Entries are sorted into 4 levels of 64 slots each. Level 0 covers the
+        next 64ms with one slot per tick, every further level covers 64 times
+        the range of the previous one. Whenever the lower level wraps around,
+        the entries of the next slot of the higher level are redistributed
+        (cascaded) to the lower levels. Entries further away than the highest
+        level can hold (about 4.6 hours) are kept in an overflow list.
+
+        Adding and cancelling an entry is O(1). The entries are kept in a slab
+        that is reused, so in the steady state no allocations happen at all.
+        Ids contain a generation counter, so a stale id never cancels an entry
+        that reused its slot.
+
+        The wheel does not invoke the payloads itself. advance() moves all
+        expired entries to a list of due entries, takeDue() hands them out one
+        by one and finish() either re-arms (periodic entries) or releases
+        them. This allows the owner to call the payload without holding its
+        lock.
+
+        TimerWheel is not thread safe.
+     */
+    template <class Payload> class TimerWheel
+    {
+      public:
+        using Clock = std::chrono::steady_clock;
+        using TimePoint = Clock::time_point;
+        using Tick = std::chrono::milliseconds;
+        using Id = uint64_t;
+
+        static constexpr Id InvalidId = 0;
+
+      public:
+        TimerWheel(TimePoint start = Clock::now()) : _start(start) {}
+        TimerWheel(const TimerWheel &) = delete;
+        TimerWheel &operator=(const TimerWheel &) = delete;
+
+      public:
+        /** Adds an entry that expires at due. If interval is not zero the
+            entry is periodic and re-armed by finish() until it is
+            cancelled. */
+        Id add(TimePoint due, Payload payload, Clock::duration interval = Clock::duration::zero())
+        {
+            uint32_t index = allocate();
+            Entry &entry = _entries[index];
+
+            entry.payload = std::move(payload);
+            entry.expiry = toTick(due);
+            entry.periodic = interval > Clock::duration::zero();
+            entry.interval =
+                entry.periodic ? std::max<uint64_t>(1, static_cast<uint64_t>(std::chrono::ceil<Tick>(interval).count()))
+                               : 0;
+            entry.state = State::Armed;
+
+            schedule(index);
+            _size++;
+
+            return makeId(index, entry.generation);
+        }
+
+        /** Cancels the entry with the given id. Returns false if the entry has
+            already expired (and was not periodic) or was cancelled before.
+
+            Entries that are currently handed out by takeDue() are released by
+            the following finish() call instead of being re-armed. */
+        bool cancel(Id id)
+        {
+            Entry *entry = find(id);
+            if (entry == nullptr) {
+                return false;
+            }
+
+            if (entry->state == State::Firing) {
+                entry->state = State::Cancelled;
+                return true;
+            }
+            if (entry->state != State::Armed) {
+                return false;
+            }
+
+            uint32_t index = indexOf(id);
+            unlink(index);
+            release(index);
+            return true;
+        }
+
+        /** Moves all entries that are due at now to the list of due
+            entries. */
+        void advance(TimePoint now)
+        {
+            uint64_t target = toTickFloor(now);
+
+            while (_currentTick < target) {
+                if (!hasScheduledEntries()) {
+                    // Nothing left on the wheel, no need to walk the ticks
+                    _currentTick = target;
+                    break;
+                }
+
+                // The next tick at which something can happen is either an
+                // occupied slot on level 0 or the next cascade.
+                uint64_t next = ((_currentTick >> SlotBits) + 1) << SlotBits;
+                unsigned currentSlot = _currentTick & SlotMask;
+                if (currentSlot != SlotMask) {
+                    uint64_t ahead = _occupied[0] & (~uint64_t(0) << (currentSlot + 1));
+                    if (ahead != 0) {
+                        next = (_currentTick & ~uint64_t(SlotMask)) + countTrailingZeros(ahead);
+                    }
+                }
+
+                if (next > target) {
+                    _currentTick = target;
+                    break;
+                }
+
+                _currentTick = next;
+
+                if ((next & SlotMask) == 0) {
+                    cascade();
+                }
+
+                moveToDue(listIndex(0, next & SlotMask));
+            }
+        }
+
+        /** Hands out the next due entry. The entry stays reserved until
+            finish() is called with its id. */
+        bool takeDue(Id &id, Payload &payload)
+        {
+            uint32_t index = _lists[DueList].head;
+            if (index == None) {
+                return false;
+            }
+
+            unlink(index);
+
+            Entry &entry = _entries[index];
+            entry.state = State::Firing;
+            id = makeId(index, entry.generation);
+            payload = std::move(entry.payload);
+            return true;
+        }
+
+        /** Completes an entry handed out by takeDue(). Periodic entries are
+            re-armed with the given payload if rearm is true and they were not
+            cancelled in the meantime. */
+        void finish(Id id, Payload payload, bool rearm, TimePoint now)
+        {
+            Entry *entry = find(id);
+            if (entry == nullptr) {
+                return;
+            }
+
+            uint32_t index = indexOf(id);
+            if (entry->state == State::Firing && entry->periodic && rearm) {
+                entry->payload = std::move(payload);
+                entry->expiry = std::max(entry->expiry + entry->interval, toTick(now));
+                entry->state = State::Armed;
+                schedule(index);
+            } else {
+                release(index);
+            }
+        }
+
+        /** The next point in time at which advance() has something to do.
+            This is either the expiry of the next entry or the next time
+            entries have to be cascaded to a lower level. */
+        std::optional<TimePoint> nextExpiry() const
+        {
+            if (_lists[DueList].count > 0) {
+                return toTimePoint(_currentTick);
+            }
+
+            std::optional<uint64_t> next;
+            for (unsigned level = 0; level < Levels; level++) {
+                if (_occupied[level] == 0) {
+                    continue;
+                }
+
+                unsigned shift = level * SlotBits;
+                unsigned currentSlot = (_currentTick >> shift) & SlotMask;
+                uint64_t tick = ((_currentTick >> shift) + distanceToNextOccupied(_occupied[level], currentSlot))
+                                << shift;
+
+                if (!next || tick < *next) {
+                    next = tick;
+                }
+            }
+
+            if (_lists[OverflowList].count > 0) {
+                uint64_t tick = ((_currentTick >> (Levels * SlotBits)) + 1) << (Levels * SlotBits);
+                if (!next || tick < *next) {
+                    next = tick;
+                }
+            }
+
+            if (next) {
+                return toTimePoint(*next);
+            }
+            return std::nullopt;
+        }
+
+        size_t size() const { return _size; }
+        bool empty() const { return _size == 0; }
+
+        void clear()
+        {
+            // Entries are released one by one rather than dropping the slab,
+            // so that ids handed out before stay invalid.
+            for (uint32_t index = 0; index < _entries.size(); index++) {
+                if (_entries[index].state != State::Free) {
+                    release(index);
+                }
+            }
+            _lists.fill(List{});
+            _occupied.fill(0);
+        }
+
+      private:
+        static constexpr unsigned SlotBits = 6;
+        static constexpr unsigned Slots = 1u << SlotBits;
+        static constexpr unsigned SlotMask = Slots - 1;
+        static constexpr unsigned Levels = 4;
+
+        static constexpr unsigned OverflowList = Levels * Slots;
+        static constexpr unsigned DueList = OverflowList + 1;
+        static constexpr unsigned NumberOfLists = DueList + 1;
+
+        static constexpr uint32_t None = UINT32_MAX;
+
+        enum class State : uint8_t
+        {
+            Free,
+            Armed,
+            Firing,
+            Cancelled
+        };
+
+        struct Entry
+        {
+            Payload payload{};
+            uint64_t expiry = 0;
+            uint64_t interval = 0;
+            uint32_t generation = 0;
+            uint32_t previous = None;
+            uint32_t next = None;
+            uint16_t list = 0;
+            State state = State::Free;
+            bool periodic = false;
+        };
+
+        struct List
+        {
+            uint32_t head = None;
+            uint32_t tail = None;
+            uint32_t count = 0;
+        };
+
+      private:
+        static unsigned listIndex(unsigned level, unsigned slot) { return level * Slots + slot; }
+
+        static Id makeId(uint32_t index, uint32_t generation) { return (Id(generation) << 32) | index; }
+        static uint32_t indexOf(Id id) { return static_cast<uint32_t>(id & UINT32_MAX); }
+        static uint32_t generationOf(Id id) { return static_cast<uint32_t>(id >> 32); }
+
+        static unsigned countTrailingZeros(uint64_t value)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<unsigned>(__builtin_ctzll(value));
+#else
+            unsigned n = 0;
+            while ((value & 1) == 0) {
+                value >>= 1;
+                n++;
+            }
+            return n;
+#endif
+        }
+
+        bool hasScheduledEntries() const
+        {
+            for (auto occupied : _occupied) {
+                if (occupied != 0) {
+                    return true;
+                }
+            }
+            return _lists[OverflowList].count > 0;
+        }
+
+        /** Number of slots (1 to 64) from current to the next occupied slot.
+            The current slot itself is only reached after a full turn. */
+        static uint64_t distanceToNextOccupied(uint64_t occupied, unsigned current)
+        {
+            unsigned shift = (current + 1) & SlotMask;
+            uint64_t rotated = shift == 0 ? occupied : (occupied >> shift) | (occupied << (Slots - shift));
+            return countTrailingZeros(rotated) + 1;
+        }
+
+        uint64_t toTick(TimePoint timePoint) const
+        {
+            if (timePoint <= _start) {
+                return 0;
+            }
+            return std::chrono::ceil<Tick>(timePoint - _start).count();
+        }
+
+        uint64_t toTickFloor(TimePoint timePoint) const
+        {
+            if (timePoint <= _start) {
+                return 0;
+            }
+            return std::chrono::floor<Tick>(timePoint - _start).count();
+        }
+
+        TimePoint toTimePoint(uint64_t tick) const { return _start + Tick(tick); }
+
+        Entry *find(Id id)
+        {
+            uint32_t index = indexOf(id);
+            if (id == InvalidId || index >= _entries.size()) {
+                return nullptr;
+            }
+
+            Entry &entry = _entries[index];
+            if (entry.generation != generationOf(id) || entry.state == State::Free) {
+                return nullptr;
+            }
+            return &entry;
+        }
+
+        uint32_t allocate()
+        {
+            if (!_freeList.empty()) {
+                uint32_t index = _freeList.back();
+                _freeList.pop_back();
+                return index;
+            }
+
+            _entries.emplace_back();
+            _entries.back().generation = 1;
+            return static_cast<uint32_t>(_entries.size() - 1);
+        }
+
+        void release(uint32_t index)
+        {
+            Entry &entry = _entries[index];
+            entry.payload = Payload{};
+            entry.state = State::Free;
+
+            // Skip 0, so that no valid id ever equals InvalidId
+            if (++entry.generation == 0) {
+                entry.generation = 1;
+            }
+
+            _freeList.push_back(index);
+            _size--;
+        }
+
+        void schedule(uint32_t index)
+        {
+            Entry &entry = _entries[index];
+
+            if (entry.expiry <= _currentTick) {
+                link(index, DueList);
+                return;
+            }
+
+            uint64_t delta = entry.expiry - _currentTick;
+            for (unsigned level = 0; level < Levels; level++) {
+                if (delta < (uint64_t(1) << ((level + 1) * SlotBits))) {
+                    unsigned slot = (entry.expiry >> (level * SlotBits)) & SlotMask;
+                    link(index, listIndex(level, slot));
+                    _occupied[level] |= uint64_t(1) << slot;
+                    return;
+                }
+            }
+
+            link(index, OverflowList);
+        }
+
+        void cascade()
+        {
+            // _currentTick is a multiple of 64. Each higher level is only
+            // cascaded if the level below it wrapped around as well.
+            for (unsigned level = 1; level < Levels; level++) {
+                unsigned slot = (_currentTick >> (level * SlotBits)) & SlotMask;
+                reschedule(listIndex(level, slot));
+                if (slot != 0) {
+                    return;
+                }
+            }
+            reschedule(OverflowList);
+        }
+
+        void reschedule(unsigned listIndex)
+        {
+            List list = detach(listIndex);
+            for (uint32_t index = list.head; index != None;) {
+                uint32_t next = _entries[index].next;
+                schedule(index);
+                index = next;
+            }
+        }
+
+        void moveToDue(unsigned listIndex)
+        {
+            List list = detach(listIndex);
+            for (uint32_t index = list.head; index != None;) {
+                uint32_t next = _entries[index].next;
+                link(index, DueList);
+                index = next;
+            }
+        }
+
+        List detach(unsigned listIndex)
+        {
+            List list = _lists[listIndex];
+            _lists[listIndex] = List{};
+            if (listIndex < OverflowList) {
+                _occupied[listIndex / Slots] &= ~(uint64_t(1) << (listIndex % Slots));
+            }
+            return list;
+        }
+
+        void link(uint32_t index, unsigned listIndex)
+        {
+            Entry &entry = _entries[index];
+            List &list = _lists[listIndex];
+
+            entry.list = static_cast<uint16_t>(listIndex);
+            entry.next = None;
+            entry.previous = list.tail;
+
+            if (list.tail != None) {
+                _entries[list.tail].next = index;
+            } else {
+                list.head = index;
+            }
+            list.tail = index;
+            list.count++;
+        }
+
+        void unlink(uint32_t index)
+        {
+            Entry &entry = _entries[index];
+            List &list = _lists[entry.list];
+
+            if (entry.previous != None) {
+                _entries[entry.previous].next = entry.next;
+            } else {
+                list.head = entry.next;
+            }
+            if (entry.next != None) {
+                _entries[entry.next].previous = entry.previous;
+            } else {
+                list.tail = entry.previous;
+            }
+            list.count--;
+
+            if (list.count == 0 && entry.list < OverflowList) {
+                _occupied[entry.list / Slots] &= ~(uint64_t(1) << (entry.list % Slots));
+            }
+
+            entry.previous = entry.next = None;
+        }
+
+      private:
+        TimePoint _start;
+        uint64_t _currentTick = 0;
+
+        std::deque<Entry> _entries;
+        std::vector<uint32_t> _freeList;
+        size_t _size = 0;
+
+        std::array<List, NumberOfLists> _lists{};
+        std::array<uint64_t, Levels> _occupied{};
+    };
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace bdn
+{
+    template <class _Fp, size_t InlineSize = 48> class UniqueFunction;
+
+    /** Move-only replacement for std::function.
+
+        Callables of up to InlineSize bytes that can be moved without throwing
+        are stored inside the UniqueFunction object itself, larger ones are
+        allocated on the heap. Since UniqueFunction is never copied, it can
+        also hold callables that are move-only themselves, like lambdas that
+        capture a std::unique_ptr or a std::packaged_task.
+
+        Calling an empty UniqueFunction throws std::bad_function_call, just
+        like std::function does.
+     */
+    template <class ReturnType, class... Arguments, size_t InlineSize>
+    class UniqueFunction<ReturnType(Arguments...), InlineSize>
+    {
+      public:
+        UniqueFunction() noexcept = default;
+        UniqueFunction(std::nullptr_t) noexcept {}
+
+        template <class F, class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, UniqueFunction> &&
+                                                    std::is_invocable_r_v<ReturnType, std::decay_t<F> &, Arguments...>>>
+        UniqueFunction(F &&function)
+        {
+            using Callable = std::decay_t<F>;
+
+            if (isEmpty(function)) {
+                return;
+            }
+
+            if constexpr (storedInline<Callable>()) {
+                new (&_storage) Callable(std::forward<F>(function));
+                _operations = &inlineOperations<Callable>;
+            } else {
+                *reinterpret_cast<Callable **>(&_storage) = new Callable(std::forward<F>(function));
+                _operations = &heapOperations<Callable>;
+            }
+        }
+
+        UniqueFunction(UniqueFunction &&other) noexcept { moveFrom(other); }
+
+        UniqueFunction(const UniqueFunction &) = delete;
+        UniqueFunction &operator=(const UniqueFunction &) = delete;
+
+        ~UniqueFunction() { reset(); }
+
+        UniqueFunction &operator=(UniqueFunction &&other) noexcept
+        {
+            if (this != &other) {
+                reset();
+                moveFrom(other);
+            }
+            return *this;
+        }
+
+        UniqueFunction &operator=(std::nullptr_t) noexcept
+        {
+            reset();
+            return *this;
+        }
+
+        template <class F, class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, UniqueFunction>>>
+        UniqueFunction &operator=(F &&function)
+        {
+            return *this = UniqueFunction(std::forward<F>(function));
+        }
+
+      public:
+        ReturnType operator()(Arguments... arguments) const
+        {
+            if (_operations == nullptr) {
+                throw std::bad_function_call();
+            }
+            return _operations->invoke(&_storage, std::forward<Arguments>(arguments)...);
+        }
+
+        explicit operator bool() const noexcept { return _operations != nullptr; }
+
+        friend bool operator==(const UniqueFunction &function, std::nullptr_t) noexcept { return !function; }
+        friend bool operator!=(const UniqueFunction &function, std::nullptr_t) noexcept { return !!function; }
+
+        /** True if a callable of type F would be stored without allocating */
+        template <class F> static constexpr bool storedInline()
+        {
+            return sizeof(F) <= InlineSize && alignof(F) <= alignof(Storage) && std::is_nothrow_move_constructible_v<F>;
+        }
+
+      private:
+        using Storage = std::aligned_storage_t<(InlineSize < sizeof(void *) ? sizeof(void *) : InlineSize),
+                                               alignof(std::max_align_t)>;
+
+        struct Operations
+        {
+            ReturnType (*invoke)(Storage *, Arguments &&...);
+            void (*move)(Storage *destination, Storage *source) noexcept;
+            void (*destroy)(Storage *) noexcept;
+        };
+
+        template <class Callable> static Callable &inlineCallable(Storage *storage)
+        {
+            return *std::launder(reinterpret_cast<Callable *>(storage));
+        }
+
+        template <class Callable> static Callable *&heapCallable(Storage *storage)
+        {
+            return *reinterpret_cast<Callable **>(storage);
+        }
+
+        template <class Callable> static ReturnType invokeInline(Storage *storage, Arguments &&... arguments)
+        {
+            return std::invoke(inlineCallable<Callable>(storage), std::forward<Arguments>(arguments)...);
+        }
+
+        template <class Callable> static void moveInline(Storage *destination, Storage *source) noexcept
+        {
+            new (destination) Callable(std::move(inlineCallable<Callable>(source)));
+            inlineCallable<Callable>(source).~Callable();
+        }
+
+        template <class Callable> static void destroyInline(Storage *storage) noexcept
+        {
+            inlineCallable<Callable>(storage).~Callable();
+        }
+
+        template <class Callable> static ReturnType invokeHeap(Storage *storage, Arguments &&... arguments)
+        {
+            return std::invoke(*heapCallable<Callable>(storage), std::forward<Arguments>(arguments)...);
+        }
+
+        template <class Callable> static void moveHeap(Storage *destination, Storage *source) noexcept
+        {
+            heapCallable<Callable>(destination) = heapCallable<Callable>(source);
+        }
+
+        template <class Callable> static void destroyHeap(Storage *storage) noexcept
+        {
+            delete heapCallable<Callable>(storage);
+        }
+
+        template <class Callable>
+        static constexpr Operations inlineOperations = {&invokeInline<Callable>, &moveInline<Callable>,
+                                                        &destroyInline<Callable>};
+
+        template <class Callable>
+        static constexpr Operations heapOperations = {&invokeHeap<Callable>, &moveHeap<Callable>,
+                                                      &destroyHeap<Callable>};
+
+        template <class T> struct IsStdFunction : std::false_type
+        {
+        };
+        template <class Signature> struct IsStdFunction<std::function<Signature>> : std::true_type
+        {
+        };
+
+        template <class F> static bool isEmpty(const F &function)
+        {
+            if constexpr (std::is_pointer_v<F> || std::is_member_pointer_v<F> || IsStdFunction<F>::value) {
+                return function == nullptr;
+            } else {
+                return false;
+            }
+        }
+
+        void moveFrom(UniqueFunction &other) noexcept
+        {
+            if (other._operations != nullptr) {
+                other._operations->move(&_storage, &other._storage);
+                _operations = other._operations;
+                other._operations = nullptr;
+            }
+        }
+
+        void reset() noexcept
+        {
+            if (_operations != nullptr) {
+                _operations->destroy(&_storage);
+                _operations = nullptr;
+            }
+        }
+
+      private:
+        mutable Storage _storage;
+        const Operations *_operations = nullptr;
+    };
+}
@@ -1,61 +1,198 @@
 #pragma once
 
-#include <functional>
+#include <bdn/UniqueFunction.h>
+
 #include <memory>
+#include <utility>
 
 namespace bdn
 {
+    namespace detail
+    {
+        template <class FunctionPointer> class WeakCallbackBase;
+
+        /** Owns the function of a WeakCallback. The callback is disconnected
+            when the receiver is destroyed, so the receiver is meant to be a
+            member of the object the function refers to. */
+        template <class FunctionPointer> class WeakCallbackReceiver
+        {
+          public:
+            WeakCallbackReceiver() = default;
+            WeakCallbackReceiver(const WeakCallbackReceiver &) = delete;
+            WeakCallbackReceiver(WeakCallbackReceiver &&other) noexcept { takeOver(other); }
+            ~WeakCallbackReceiver() { reset(); }
+
+            WeakCallbackReceiver &operator=(const WeakCallbackReceiver &) = delete;
+            WeakCallbackReceiver &operator=(WeakCallbackReceiver &&other) noexcept
+            {
+                if (this != &other) {
+                    reset();
+                    takeOver(other);
+                }
+                return *this;
+            }
+
+            explicit operator bool() const { return _callback != nullptr; }
+
+            /** Disconnects from the callback and releases the function */
+            void reset()
+            {
+                if (_callback != nullptr) {
+                    _callback->receiverDestroyed(std::move(_function));
+                    _callback = nullptr;
+                }
+                _function.reset();
+            }
+
+          private:
+            void takeOver(WeakCallbackReceiver &other)
+            {
+                _function = std::move(other._function);
+                _callback = std::exchange(other._callback, nullptr);
+                if (_callback != nullptr) {
+                    _callback->_receiver = this;
+                }
+            }
+
+            friend class WeakCallbackBase<FunctionPointer>;
+
+          private:
+            // On the heap, so that the function does not move while it runs
+            std::unique_ptr<FunctionPointer> _function;
+            WeakCallbackBase<FunctionPointer> *_callback = nullptr;
+        };
+
+        /** Links a callback and its receiver without shared ownership.
+
+            Either side can be destroyed first, also from within the
+            function. A receiver destroyed while its function runs hands the
+            function over to the running fire(), which releases it when the
+            outermost call returns. Not thread safe.
+         */
+        template <class FunctionPointer> class WeakCallbackBase
+        {
+          public:
+            using Receiver = WeakCallbackReceiver<FunctionPointer>;
+
+            WeakCallbackBase() = default;
+            WeakCallbackBase(const WeakCallbackBase &) = delete;
+            WeakCallbackBase &operator=(const WeakCallbackBase &) = delete;
+
+            ~WeakCallbackBase()
+            {
+                if (_receiver != nullptr) {
+                    _receiver->_callback = nullptr;
+                }
+                for (auto call = _call; call != nullptr; call = call->outer) {
+                    call->callbackDestroyed = true;
+                }
+            }
+
+            Receiver set(FunctionPointer &&callback)
+            {
+                if (_receiver != nullptr) {
+                    _receiver->_callback = nullptr;
+                }
+
+                Receiver receiver;
+                receiver._function = std::make_unique<FunctionPointer>(std::move(callback));
+                receiver._callback = this;
+                _receiver = &receiver;
+                return receiver;
+            }
+
+          protected:
+            /** Calls the function, or fallback if there is no receiver */
+            template <class Fallback, class... Arguments>
+            decltype(auto) invoke(Fallback &&fallback, Arguments &&... arguments)
+            {
+                if (_receiver == nullptr) {
+                    return fallback();
+                }
+
+                CallScope scope(*this);
+                return (*_receiver->_function)(std::forward<Arguments>(arguments)...);
+            }
+
+          private:
+            struct Call
+            {
+                Call *outer = nullptr;
+                bool callbackDestroyed = false;
+                std::unique_ptr<FunctionPointer> orphanedFunction;
+            };
+
+            class CallScope
+            {
+              public:
+                explicit CallScope(WeakCallbackBase &callback) : _callback(callback)
+                {
+                    _call.outer = std::exchange(callback._call, &_call);
+                }
+                ~CallScope()
+                {
+                    if (!_call.callbackDestroyed) {
+                        _callback._call = _call.outer;
+                    }
+                }
+
+              private:
+                WeakCallbackBase &_callback;
+                Call _call;
+            };
+
+            void receiverDestroyed(std::unique_ptr<FunctionPointer> function)
+            {
+                _receiver = nullptr;
+
+                // Keep the function alive until the outermost call returns
+                if (auto call = _call) {
+                    while (call->outer != nullptr) {
+                        call = call->outer;
+                    }
+                    call->orphanedFunction = std::move(function);
+                }
+            }
+
+            friend class WeakCallbackReceiver<FunctionPointer>;
+
+          private:
+            WeakCallbackReceiver<FunctionPointer> *_receiver = nullptr;
+            Call *_call = nullptr;
+        };
+    }
+
     template <class _Fp> class WeakCallback;
 
-    template <typename... Arguments> class WeakCallback<void(Arguments...)>
+    template <typename... Arguments>
+    class WeakCallback<void(Arguments...)> : public detail::WeakCallbackBase<UniqueFunction<void(Arguments...)>>
     {
       public:
-        using FunctionPointer = std::function<void(Arguments...)>;
-        using Receiver = std::shared_ptr<FunctionPointer>;
+        using FunctionPointer = UniqueFunction<void(Arguments...)>;
+        using Receiver = detail::WeakCallbackReceiver<FunctionPointer>;
 
         void fire(Arguments... arguments)
         {
-            if (auto callback = _callback.lock()) {
-                (*callback)(arguments...);
-            }
-        }
-
-        auto set(FunctionPointer &&callback)
-        {
-            auto result = std::make_shared<FunctionPointer>(std::move(callback));
-            _callback = result;
-            return result;
+            this->invoke([]() {}, arguments...);
         }
-
-      private:
-        std::weak_ptr<FunctionPointer> _callback;
     };
 
-    template <typename ReturnType, typename... Arguments> class WeakCallback<ReturnType(Arguments...)>
+    template <typename ReturnType, typename... Arguments>
+    class WeakCallback<ReturnType(Arguments...)>
+        : public detail::WeakCallbackBase<UniqueFunction<ReturnType(Arguments...)>>
     {
       public:
-        using FunctionPointer = std::function<ReturnType(Arguments...)>;
-        using Receiver = std::shared_ptr<FunctionPointer>;
+        using FunctionPointer = UniqueFunction<ReturnType(Arguments...)>;
+        using Receiver = detail::WeakCallbackReceiver<FunctionPointer>;
 
         WeakCallback(ReturnType defaultReturnValue = ReturnType()) : _defaultReturnValue(defaultReturnValue) {}
 
         ReturnType fire(Arguments... arguments)
         {
-            if (auto callback = _callback.lock()) {
-                return (*callback)(arguments...);
-            }
-            return _defaultReturnValue;
-        }
-
-        auto set(FunctionPointer &&callback)
-        {
-            auto result = std::make_shared<FunctionPointer>(std::move(callback));
-            _callback = result;
-            return result;
+            return this->invoke([this]() { return _defaultReturnValue; }, arguments...);
         }
 
       private:
-        std::weak_ptr<FunctionPointer> _callback;
         const ReturnType _defaultReturnValue;
     };
 }
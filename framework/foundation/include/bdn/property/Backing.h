@@ -1,7 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <bdn/DispatchQueue.h>
 #include <bdn/Notifier.h>
+#include <bdn/property/PropertyTransaction.h>
 #include <memory>
+#include <optional>
 #include <utility>
 #include <vector>
 
@@ -12,15 +16,24 @@ namespace bdn
     template <class ValType> class Backing : public std::enable_shared_from_this<Backing<ValType>>
     {
       public:
+        /** Gives operator-> access to the value of a backing. Refers to the
+            stored value if the backing has one (see peek()), otherwise it
+            holds a copy. */
         class Proxy
         {
           public:
             Proxy(ValType value) : _value(std::move(value)) {}
 
-            const ValType *operator->() const { return &_value; }
+            static Proxy reference(const ValType &value) { return Proxy(&value); }
+
+            const ValType *operator->() const { return _reference != nullptr ? _reference : &*_value; }
+
+          private:
+            explicit Proxy(const ValType *reference) : _reference(reference) {}
 
           private:
-            ValType _value;
+            std::optional<ValType> _value;
+            const ValType *_reference = nullptr;
         };
 
         using notifier_t = Notifier<std::shared_ptr<Backing<ValType>>>;
@@ -36,7 +49,18 @@ namespace bdn
         virtual ValType get() const = 0;
         virtual void set(const ValType &value, bool notify = true) = 0;
 
-        virtual Proxy proxy() const { return Proxy(get()); }
+        /** Returns a pointer to the stored value, or nullptr if the backing
+            does not store its value (e.g. because it computes it). The
+            pointer is valid until the value is changed. */
+        virtual const ValType *peek() const { return nullptr; }
+
+        virtual Proxy proxy() const
+        {
+            if (auto value = peek()) {
+                return Proxy::reference(*value);
+            }
+            return Proxy(get());
+        }
 
         notifier_t &onChange() { return _onChange; }
 
@@ -46,28 +70,89 @@ namespace bdn
                               std::is_constructible<OtherType, ValType>::value,
                           "Types are not convertible");
 
-            auto subscription = sourceBacking->onChange().subscribe(
-                [this](const auto &sourceBacking) { this->bindSourceChanged(sourceBacking); });
+            _bindings.push_back(sourceBacking->onChange().connect(
+                [this](const auto &sourceBacking) { this->bindSourceChanged(sourceBacking); }));
+
+            bindSourceChanged(sourceBacking);
+        }
 
-            std::weak_ptr<Backing<OtherType>> weakSourceBacking = sourceBacking;
+        /** Like bind(), for a source that is changed on another thread. The
+            new values are set on queue, which should be the queue owning this
+            backing.
+
+            Changes are coalesced, only the latest value is set. That happens
+            at the end of the queue's current frame (see
+            DispatchQueue::dispatchAtFrameEnd()) or, if minInterval is not
+            zero, at most once per minInterval.
+
+            The binding must be established before the source is changed on
+            its thread. It can be removed with unbind() on this backing's
+            thread at any time.
+         */
+        template <typename OtherType>
+        void bind(std::shared_ptr<Backing<OtherType>> sourceBacking, std::shared_ptr<DispatchQueue> queue,
+                  DispatchQueue::Clock::duration minInterval = {})
+        {
+            static_assert(std::is_convertible<OtherType, ValType>::value ||
+                              std::is_constructible<OtherType, ValType>::value,
+                          "Types are not convertible");
 
-            Binding binding = [subscription, weakSourceBacking]() {
-                if (auto source = weakSourceBacking.lock()) {
-                    source->onChange().unsubscribe(subscription);
-                }
+            struct QueuedBinding
+            {
+                std::weak_ptr<Backing<ValType>> target;
+                std::weak_ptr<DispatchQueue> queue;
+                DispatchQueue::Clock::duration minInterval;
+                notifier_subscription_t subscription;
+                std::atomic<bool> active{true};
             };
 
-            _bindings.push_back(binding);
+            auto binding = std::make_shared<QueuedBinding>();
+            binding->target = this->shared_from_this();
+            binding->queue = queue;
+            binding->minInterval = minInterval;
+
+            // Runs on the source's thread. The binding is also the coalescing
+            // key, each pending function keeps it alive so that the key is
+            // not reused.
+            binding->subscription = sourceBacking->onChange().subscribe([binding](const auto &source) {
+                if (!binding->active) {
+                    source->onChange().unsubscribe(binding->subscription);
+                    return;
+                }
+
+                auto queue = binding->queue.lock();
+                if (!queue) {
+                    return;
+                }
+
+                DispatchQueue::Function update = [binding, value = source->get()]() {
+                    if (auto target = binding->target.lock(); target && binding->active) {
+                        target->set(value);
+                    }
+                };
+
+                if (binding->minInterval == DispatchQueue::Clock::duration::zero()) {
+                    queue->dispatchAtFrameEnd(binding.get(), std::move(update));
+                } else {
+                    queue->dispatchAsyncThrottled(binding.get(), binding->minInterval, std::move(update));
+                }
+            });
+
+            // The source's notifier must only be touched on its own thread,
+            // the subscription removes itself on the next change.
+            _queuedBindings.emplace_back(binding, &binding->active);
 
             bindSourceChanged(sourceBacking);
         }
 
         void unbind()
         {
-            for (const auto &unbind : _bindings) {
-                unbind();
-            }
             _bindings.clear();
+
+            for (const auto &active : _queuedBindings) {
+                *active = false;
+            }
+            _queuedBindings.clear();
         }
 
       public:
@@ -77,10 +162,29 @@ namespace bdn
         }
 
       protected:
-        notifier_t _onChange;
+        /** Notifies the subscribers of onChange(), or defers the notification
+            to the end of the current PropertyTransaction. */
+        void notifyChange()
+        {
+            auto self = this->shared_from_this();
+
+            if (PropertyTransaction::isActive()) {
+                std::weak_ptr<Backing<ValType>> weakSelf = self;
+                PropertyTransaction::defer(self, [weakSelf]() {
+                    if (auto backing = weakSelf.lock()) {
+                        backing->_onChange.notify(backing);
+                    }
+                });
+                return;
+            }
 
-        using Binding = std::function<void()>;
+            _onChange.notify(self);
+        }
+
+      protected:
+        notifier_t _onChange;
 
-        std::vector<Binding> _bindings;
+        std::vector<NotifierConnection> _bindings;
+        std::vector<std::shared_ptr<std::atomic<bool>>> _queuedBindings;
     };
 }
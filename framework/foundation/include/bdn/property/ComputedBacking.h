@@ -0,0 +1,186 @@
+#pragma once
+
+#include <bdn/property/Backing.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace bdn
+{
+    namespace detail
+    {
+        /** A node in the graph of computed backings.
+
+            A change of a source is propagated in two phases: first every
+            node depending on it is marked dirty, then the marked nodes notify
+            their subscribers ordered by their level (the length of the
+            longest path from a plain source). A subscriber therefore never
+            reads a value computed from stale inputs, and a node reachable
+            via several paths is notified only once per change.
+         */
+        class ComputedNode
+        {
+          public:
+            virtual ~ComputedNode() = default;
+
+            size_t level() const { return _level; }
+
+            void addDependent(ComputedNode *dependent);
+            void removeDependent(ComputedNode *dependent);
+
+            /** Invalidates all dependents and notifies them in order */
+            void sourceChanged();
+
+          protected:
+            virtual std::weak_ptr<ComputedNode> weakNode() = 0;
+            virtual void notifyDependents() = 0;
+
+          private:
+            void invalidate(uint64_t propagation,
+                            std::vector<std::pair<size_t, std::weak_ptr<ComputedNode>>> &invalidated);
+
+          protected:
+            size_t _level = 0;
+            mutable bool _dirty = true;
+
+          private:
+            uint64_t _propagation = 0;
+            std::vector<ComputedNode *> _dependents;
+        };
+
+        /** Represents a plain (not computed) source backing in the graph.
+
+            All computed backings reading the same source share one node, so
+            that a change of the source is propagated to all of them at once.
+         */
+        class ComputedSourceNode : public ComputedNode, public std::enable_shared_from_this<ComputedSourceNode>
+        {
+          public:
+            using Connect = std::function<std::function<void()>(ComputedSourceNode *)>;
+
+            ~ComputedSourceNode() override;
+
+            /** Returns the node of backing, calls connect to subscribe a new
+                node to the backing's changes. connect returns the function
+                to unsubscribe again. */
+            static std::shared_ptr<ComputedSourceNode> forBacking(const std::shared_ptr<const void> &backing,
+                                                                  const Connect &connect);
+
+          protected:
+            std::weak_ptr<ComputedNode> weakNode() override { return {}; }
+            void notifyDependents() override {}
+
+          private:
+            std::weak_ptr<const void> _backing;
+            std::function<void()> _disconnect;
+        };
+    }
+
+    /** A read-only backing whose value is computed from any number of source
+        properties.
+
+        The result is cached. A change of a source only marks the backing
+        dirty and notifies the subscribers, the value is computed again on
+        the next read.
+     */
+    template <class ValType, class... SourceTypes>
+    class ComputedBacking : public Backing<ValType>, public detail::ComputedNode
+    {
+      public:
+        using Function = std::function<ValType(const SourceTypes &...)>;
+
+      public:
+        ComputedBacking(Function function, const Property<SourceTypes> &... sources)
+            : _function(std::move(function)), _sources(sources.backing()...)
+        {
+            connect(std::index_sequence_for<SourceTypes...>());
+        }
+
+        ComputedBacking(const ComputedBacking &other) : _function(other._function), _sources(other._sources)
+        {
+            connect(std::index_sequence_for<SourceTypes...>());
+        }
+
+        ~ComputedBacking() override
+        {
+            for (auto &node : _sourceNodes) {
+                node->removeDependent(this);
+            }
+        }
+
+      public:
+        ValType get() const override { return *peek(); }
+
+        const ValType *peek() const override
+        {
+            if (_dirty) {
+                _value = std::apply([this](const auto &... sources) { return _function(sources->get()...); }, _sources);
+                _dirty = false;
+            }
+            return &_value;
+        }
+
+        void set(const ValType &value, bool notify = true) override {}
+
+      protected:
+        std::weak_ptr<ComputedNode> weakNode() override
+        {
+            if (auto self = this->weak_from_this().lock()) {
+                return std::static_pointer_cast<ComputedBacking>(self);
+            }
+            return {};
+        }
+
+        void notifyDependents() override { this->notifyChange(); }
+
+      private:
+        template <size_t... Indices> void connect(std::index_sequence<Indices...>)
+        {
+            ((_sourceNodes[Indices] = sourceNode(std::get<Indices>(_sources))), ...);
+
+            for (auto &node : _sourceNodes) {
+                node->addDependent(this);
+                _level = std::max(_level, node->level() + 1);
+            }
+        }
+
+        template <class T> static std::shared_ptr<ComputedNode> sourceNode(const std::shared_ptr<Backing<T>> &source)
+        {
+            if (auto node = dynamic_cast<detail::ComputedNode *>(source.get())) {
+                return std::shared_ptr<ComputedNode>(source, node);
+            }
+
+            return detail::ComputedSourceNode::forBacking(source, [source](detail::ComputedSourceNode *node) {
+                auto subscription = source->onChange().subscribe([node](auto) { node->sourceChanged(); });
+                std::weak_ptr<Backing<T>> weakSource = source;
+
+                return std::function<void()>([weakSource, subscription]() {
+                    if (auto backing = weakSource.lock()) {
+                        backing->onChange().unsubscribe(subscription);
+                    }
+                });
+            });
+        }
+
+      private:
+        Function _function;
+        std::tuple<std::shared_ptr<Backing<SourceTypes>>...> _sources;
+        std::array<std::shared_ptr<ComputedNode>, sizeof...(SourceTypes)> _sourceNodes;
+        mutable ValType _value{};
+    };
+
+    /** Creates a ComputedBacking, deducing its value type from function */
+    template <class F, class... SourceTypes>
+    auto makeComputed(F function, const Property<SourceTypes> &... sources)
+        -> ComputedBacking<std::decay_t<std::invoke_result_t<F &, const SourceTypes &...>>, SourceTypes...>
+    {
+        return {std::move(function), sources...};
+    }
+}
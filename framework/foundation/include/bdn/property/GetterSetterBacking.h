@@ -46,6 +46,8 @@ namespace bdn
             return _getter();
         }
 
+        const ValType *peek() const override { return _getter == nullptr ? _member : nullptr; }
+
         void set(const ValType &value, bool notify = true) override
         {
             bool changed = false;
@@ -67,7 +69,7 @@ namespace bdn
             }
 
             if (changed && notify) {
-                this->_onChange.notify(Backing<ValType>::shared_from_this());
+                this->notifyChange();
             }
         }
 
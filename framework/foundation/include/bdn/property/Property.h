@@ -1,7 +1,10 @@
 #pragma once
 
 #include <string>
+#include <utility>
+#include <variant>
 
+#include <bdn/property/ComputedBacking.h>
 #include <bdn/property/GetterSetterBacking.h>
 #include <bdn/property/SetterBacking.h>
 #include <bdn/property/StreamBacking.h>
@@ -46,65 +49,129 @@ namespace bdn
       public:
         using backing_t = Backing<ValType>;
 
-        Property() : _backing(std::make_shared<value_backing_t>()) { init(); }
-        Property(Property &other) : _backing(other.backing()) { init(); }
+        Property() : _storage(valueStorage()) {}
+        Property(Property &other) : _storage(std::in_place_index<SharedBacking>, other.backing()) {}
         Property(const Property &) = delete;
         ~Property()
         {
-            if (_backing) {
-                _backing->onChange().unsubscribe(_forwardSub);
+            if (auto backing = existingBacking()) {
+                (*backing)->onChange().unsubscribe(_forwardSub);
             }
         }
 
-        Property(ValType value) : _backing(std::make_shared<value_backing_t>())
-        {
-            init();
-            set(value, false /* do not notify on initial set */);
-        }
+        Property(ValType value) : _storage(valueStorage(std::move(value))) {}
 
         Property(const GetterSetterBacking<ValType> &getterSetter)
-        {
-            _backing = std::make_shared<gs_backing_t>(getterSetter);
-            init();
-        }
+            : _storage(std::in_place_index<SharedBacking>, std::make_shared<gs_backing_t>(getterSetter))
+        {}
 
         Property(const SetterBacking<ValType> &setter)
-        {
-            _backing = std::make_shared<setter_backing_t>(setter);
-            init();
-        }
+            : _storage(std::in_place_index<SharedBacking>, std::make_shared<setter_backing_t>(setter))
+        {}
 
         Property(const StreamBacking &stream)
+            : _storage(std::in_place_index<SharedBacking>, std::make_shared<StreamBacking>(stream))
+        {}
+
+        template <class U>
+        Property(const TransformBacking<ValType, U> &transform)
+            : _storage(std::in_place_index<SharedBacking>, std::make_shared<TransformBacking<ValType, U>>(transform))
+        {}
+
+        template <class... U>
+        Property(const ComputedBacking<ValType, U...> &computed)
+            : _storage(std::in_place_index<SharedBacking>, std::make_shared<ComputedBacking<ValType, U...>>(computed))
+        {}
+
+        Property(std::shared_ptr<Backing<ValType>> backing)
+            : _storage(std::in_place_index<SharedBacking>, std::move(backing))
+        {}
+
+        template <class _Rep, class _Period>
+        Property(const std::chrono::duration<_Rep, _Period> &duration)
+            : _storage(valueStorage(std::chrono::duration_cast<ValType>(duration)))
+        {}
+
+      public:
+        ValType get() const
         {
-            _backing = std::make_shared<StreamBacking>(stream);
-            init();
+            if constexpr (StoresInline) {
+                if (_storage.index() == InlineValue) {
+                    return std::get<InlineValue>(_storage);
+                }
+            }
+            return (*existingBacking())->get();
         }
 
-        template <class U> Property(const TransformBacking<ValType, U> &transform)
+        void set(ValType value, bool notify = true)
         {
-            _backing = std::make_shared<TransformBacking<ValType, U>>(transform);
-            init();
+            // Deferred notifications need a backing that can outlive the
+            // property, see PropertyTransaction.
+            if (notify && _isConnected && PropertyTransaction::isActive()) {
+                backing();
+            }
+
+            if constexpr (StoresInline) {
+                if (_storage.index() == InlineValue) {
+                    auto &current = std::get<InlineValue>(_storage);
+                    bool changed = value_backing_t::template Compare<ValType>::notEqual(current, value);
+
+                    if (NotificationProfiler::isEnabled()) {
+                        NotificationProfiler::recordSet(&_onChange, typeid(ValType), !changed);
+                    }
+
+                    if (changed) {
+                        current = std::move(value);
+                        if (notify) {
+                            _onChange.notify(*this);
+                        }
+                    }
+                    return;
+                }
+            }
+
+            (*existingBacking())->set(value, notify);
         }
 
-        Property(std::shared_ptr<Backing<ValType>> backing)
+        /** Calls function with a const reference to the value and returns its
+            result. Unlike get(), this does not copy the value if the property
+            stores it inline or its backing stores it. The reference must not
+            be used after function returns. */
+        template <class F> decltype(auto) read(F &&function) const
         {
-            _backing = backing;
-            init();
+            if constexpr (StoresInline) {
+                if (_storage.index() == InlineValue) {
+                    return std::forward<F>(function)(std::as_const(std::get<InlineValue>(_storage)));
+                }
+            }
+
+            const auto &backing = *existingBacking();
+            if (auto value = backing->peek()) {
+                return std::forward<F>(function)(*value);
+            }
+            const ValType value = backing->get();
+            return std::forward<F>(function)(value);
         }
 
-        template <class _Rep, class _Period>
-        Property(const std::chrono::duration<_Rep, _Period> &duration) : _backing(std::make_shared<value_backing_t>())
+        /** Returns the backing of the property. A plain value property keeps
+            its value inline, the first call moves it into a ValueBacking. */
+        std::shared_ptr<backing_t> backing() const
         {
-            init();
-            set(std::chrono::duration_cast<ValType>(duration), false);
+            if constexpr (StoresInline) {
+                if (_storage.index() == InlineValue) {
+                    auto backing = std::shared_ptr<backing_t>(
+                        std::make_shared<value_backing_t>(std::move(std::get<InlineValue>(_storage))));
+                    _storage.template emplace<SharedBacking>(backing);
+
+                    if (_isConnected) {
+                        subscribeToBacking(backing);
+                    }
+                    return backing;
+                }
+            }
+            return *existingBacking();
         }
 
-      public:
-        ValType get() const { return _backing->get(); }
-        void set(ValType value, bool notify = true) { _backing->set(value, notify); }
-
-        const auto backing() const { return _backing; }
-
       public:
         template <class OtherType>
         void bind(const Property<OtherType> &sourceProperty, BindMode bindMode = BindMode::bidirectional)
@@ -117,14 +184,27 @@ namespace bdn
                     "and therefore would end up in an endless loop.");
             }
 
-            _backing->bind(sourceProperty.backing());
+            backing()->bind(sourceProperty.backing());
             if (bindMode == BindMode::bidirectional) {
-                sourceProperty.backing()->bind(_backing);
+                sourceProperty.backing()->bind(backing());
             }
         }
 
+        /** Binds the property to sourceProperty, which is changed on another
+            thread. The property is set on queue, see Backing::bind(). */
+        template <class OtherType>
+        void bind(const Property<OtherType> &sourceProperty, std::shared_ptr<DispatchQueue> queue,
+                  DispatchQueue::Clock::duration minInterval = {})
+        {
+            backing()->bind(sourceProperty.backing(), std::move(queue), minInterval);
+        }
+
       public:
-        auto &onChange() const { return _onChange; }
+        auto &onChange() const
+        {
+            connect();
+            return _onChange;
+        }
 
       public:
         template <typename U = ValType, typename std::enable_if<overloadsArrowOperator<U>::value, int>::type = 0>
@@ -136,7 +216,12 @@ namespace bdn
         template <typename U = ValType, typename std::enable_if<!overloadsArrowOperator<U>::value, int>::type = 0>
         const typename backing_t::Proxy operator->() const
         {
-            return _backing->proxy();
+            if constexpr (StoresInline) {
+                if (_storage.index() == InlineValue) {
+                    return backing_t::Proxy::reference(std::get<InlineValue>(_storage));
+                }
+            }
+            return (*existingBacking())->proxy();
         }
 
         Property &operator=(const ValType &value)
@@ -169,7 +254,7 @@ namespace bdn
                 return *this;
             }
 
-            _backing->set(otherProperty.backing()->get());
+            set(otherProperty.get());
             return *this;
         }
 
@@ -292,14 +377,53 @@ namespace bdn
         void forwardNotification() { _onChange.notify(*this); }
 
       private:
-        void init()
+        // Values that cannot be copied out of the property are always kept
+        // in a ValueBacking, like all values were before.
+        static constexpr bool StoresInline = std::is_copy_constructible<ValType>::value;
+
+        using inline_storage_t = std::conditional_t<StoresInline, ValType, std::monostate>;
+        using storage_t = std::variant<inline_storage_t, std::shared_ptr<backing_t>>;
+
+        static constexpr size_t InlineValue = 0;
+        static constexpr size_t SharedBacking = 1;
+
+        template <class... Arguments> static storage_t valueStorage(Arguments &&... arguments)
+        {
+            if constexpr (StoresInline) {
+                return storage_t(std::in_place_index<InlineValue>, std::forward<Arguments>(arguments)...);
+            } else {
+                return storage_t(std::in_place_index<SharedBacking>,
+                                 std::make_shared<value_backing_t>(std::forward<Arguments>(arguments)...));
+            }
+        }
+
+        const std::shared_ptr<backing_t> *existingBacking() const { return std::get_if<SharedBacking>(&_storage); }
+
+        // Forwarding is only set up once someone asks for onChange(), so
+        // properties nobody listens to do not subscribe to their backing.
+        // Inline values notify directly.
+        void connect() const
+        {
+            if (_isConnected) {
+                return;
+            }
+            _isConnected = true;
+
+            if (auto backing = existingBacking()) {
+                subscribeToBacking(*backing);
+            }
+        }
+
+        void subscribeToBacking(const std::shared_ptr<backing_t> &backing) const
         {
-            _forwardSub = _backing->onChange().subscribe(std::bind(&Property<ValType>::forwardNotification, this));
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+            auto self = const_cast<Property<ValType> *>(this);
+            _forwardSub = backing->onChange().subscribe(std::bind(&Property<ValType>::forwardNotification, self));
         }
 
       private:
-        typename backing_t::notifier_t::Subscription _forwardSub;
-        mutable std::shared_ptr<backing_t> _backing;
+        mutable typename backing_t::notifier_t::Subscription _forwardSub;
+        mutable storage_t _storage;
         mutable bool _isConnected = false;
 
         mutable notifier_t _onChange;
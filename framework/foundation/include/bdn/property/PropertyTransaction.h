@@ -0,0 +1,48 @@
+#pragma once
+
+#include <bdn/UniqueFunction.h>
+
+#include <memory>
+
+namespace bdn
+{
+    /** Defers property change notifications of the current thread.
+
+        While a transaction exists, backings do not notify their subscribers
+        when their value changes. The notifications are collected instead,
+        multiple changes to the same backing are collapsed into one, and
+        they are delivered in a single pass once the outermost transaction
+        on the thread ends. Subscribers then see the final values.
+
+        Transactions can be nested, only the outermost one delivers.
+     */
+    class PropertyTransaction
+    {
+      public:
+        PropertyTransaction();
+        ~PropertyTransaction();
+
+        PropertyTransaction(const PropertyTransaction &) = delete;
+        PropertyTransaction &operator=(const PropertyTransaction &) = delete;
+
+        /** Delivers the deferred notifications now, if this is the
+            outermost transaction. Changes made by subscribers during
+            delivery are batched as well and delivered afterwards.
+
+            Call this explicitly if subscribers may throw, the destructor
+            has to swallow the exception otherwise. */
+        void commit();
+
+      public:
+        /** Returns true if a transaction exists on the current thread */
+        static bool isActive();
+
+        /** Defers notify to the end of the current transaction. If a
+            notification for the same owner is already pending, notify is
+            dropped. */
+        static void defer(const std::shared_ptr<const void> &owner, UniqueFunction<void()> notify);
+
+      private:
+        bool _committed = false;
+    };
+}
@@ -17,13 +17,14 @@ namespace bdn
         SetterBacking(SetterFunc setter) : _setter(setter) {}
 
         ValType get() const override { return _value; }
+        const ValType *peek() const override { return &_value; }
 
         void set(const ValType &value, bool notify = true) override
         {
             if (_setter == nullptr) {
                 _value = value;
             } else if (_setter(_value, value) && notify) {
-                this->_onChange.notify(Backing<ValType>::shared_from_this());
+                this->notifyChange();
             }
         }
 
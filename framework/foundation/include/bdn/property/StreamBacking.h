@@ -1,6 +1,12 @@
 #pragma once
 
+#include <charconv>
+#include <iterator>
+#include <memory>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <variant>
 
 #include <bdn/property/Backing.h>
@@ -8,15 +14,54 @@
 
 namespace bdn
 {
+    namespace detail
+    {
+        /** Appends the textual representation of value to out, the same one
+            operator<< on a default std::ostream produces. Arithmetic types
+            are converted with std::to_chars, strings are appended as they
+            are, everything else goes through a std::ostringstream. */
+        template <class T> void appendStreamed(std::string &out, const T &value)
+        {
+            if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char> &&
+                          !std::is_same_v<T, signed char> && !std::is_same_v<T, unsigned char> &&
+                          !std::is_same_v<T, wchar_t> && !std::is_same_v<T, char16_t> && !std::is_same_v<T, char32_t>) {
+                char buffer[24];
+                auto result = std::to_chars(std::begin(buffer), std::end(buffer), value);
+                out.append(buffer, result.ptr);
+            }
+#if defined(__cpp_lib_to_chars)
+            else if constexpr (std::is_floating_point_v<T>) {
+                // %g with a precision of 6, like the default of std::ostream
+                char buffer[32];
+                auto result = std::to_chars(std::begin(buffer), std::end(buffer), value, std::chars_format::general, 6);
+                out.append(buffer, result.ptr);
+            }
+#endif
+            else if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+                out.append(std::string_view(value));
+            } else {
+                std::ostringstream stream;
+                stream << value;
+                out.append(stream.str());
+            }
+        }
+    }
+
+    /** Joins properties and values into a string.
+
+        Each segment keeps its rendered text. When a property changes, only
+        its segment is rendered again and the string is reassembled.
+     */
     class StreamBacking : public Backing<std::string>
     {
       private:
         struct ToStringBase
         {
             virtual ~ToStringBase() = default;
-            virtual void toString(std::ostringstream &stream) = 0;
+            virtual void render(std::string &out) = 0;
             virtual void cloneInto(StreamBacking &sb) = 0;
             Notifier<> changed;
+            std::string rendered;
         };
 
         template <class ValType> struct ToString : public ToStringBase
@@ -30,7 +75,10 @@ namespace bdn
             }
             ~ToString() { property.onChange().unsubscribe(propertySubscription); }
 
-            void toString(std::ostringstream &stream) override { stream << property.get(); }
+            void render(std::string &out) override
+            {
+                property.read([&](const ValType &value) { detail::appendStreamed(out, value); });
+            }
 
             void cloneInto(StreamBacking &sb) override { sb << property; }
         };
@@ -38,7 +86,7 @@ namespace bdn
         template <class T> struct ValueToString : public ToStringBase
         {
             ValueToString(T v) : value(std::move(v)) {}
-            void toString(std::ostringstream &stream) override { stream << value; }
+            void render(std::string &out) override { detail::appendStreamed(out, value); }
             void cloneInto(StreamBacking &sb) override { sb << value; }
 
             T value;
@@ -52,42 +100,55 @@ namespace bdn
             for (auto &p : other._properties) {
                 p->cloneInto(*this);
             }
-
-            updateValue();
         }
 
         template <class OtherValueType> StreamBacking &operator<<(const Property<OtherValueType> &other)
         {
-            std::unique_ptr<ToStringBase> newPropertyUnique(
-                std::move(std::make_unique<ToString<OtherValueType>>(other)));
-            newPropertyUnique->changed += std::bind(&StreamBacking::onPropertyChanged, this);
-            _properties.emplace_back(std::move(newPropertyUnique));
+            auto segment = std::make_unique<ToString<OtherValueType>>(other);
+            segment->changed += [this, changedSegment = segment.get()]() { onPropertyChanged(*changedSegment); };
+            append(std::move(segment));
             return *this;
         }
 
         template <class T> StreamBacking &operator<<(T value)
         {
-            std::unique_ptr<ToStringBase> newValueUnique(
-                std::move(std::make_unique<ValueToString<T>>(std::move(value))));
-            _properties.emplace_back(std::move(newValueUnique));
+            append(std::make_unique<ValueToString<T>>(std::move(value)));
             return *this;
         }
 
       protected:
+        void append(std::unique_ptr<ToStringBase> segment)
+        {
+            segment->render(segment->rendered);
+            _value.append(segment->rendered);
+            _properties.emplace_back(std::move(segment));
+        }
+
         void updateValue()
         {
-            std::ostringstream stream;
+            size_t length = 0;
             for (auto &p : _properties) {
-                p->toString(stream);
+                length += p->rendered.size();
             }
 
-            _value = stream.str();
+            _value.clear();
+            _value.reserve(length);
+            for (auto &p : _properties) {
+                _value.append(p->rendered);
+            }
         }
 
-        void onPropertyChanged()
+        void onPropertyChanged(ToStringBase &segment)
         {
+            _scratch.clear();
+            segment.render(_scratch);
+            if (_scratch == segment.rendered) {
+                return;
+            }
+
+            std::swap(segment.rendered, _scratch);
             updateValue();
-            _onChange.notify(shared_from_this());
+            notifyChange();
         }
 
       private:
@@ -95,9 +156,11 @@ namespace bdn
 
       public:
         std::string get() const override { return _value; }
+        const std::string *peek() const override { return &_value; }
         void set(const std::string &value, bool notify) override {}
 
       private:
         std::string _value;
+        std::string _scratch;
     };
 }
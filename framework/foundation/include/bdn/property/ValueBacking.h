@@ -1,5 +1,6 @@
 #pragma once
 
+#include <bdn/NotificationProfiler.h>
 #include <bdn/property/Backing.h>
 #include <optional>
 
@@ -14,6 +15,7 @@ namespace bdn
         ValueBacking(const ValueBacking &other) : _value(other.get()) {}
 
         ValType get() const override { return _value; }
+        const ValType *peek() const override { return &_value; }
 
         void set(const ValType &value, bool notify = true) override
         {
@@ -26,8 +28,12 @@ namespace bdn
                 }
             }
 
+            if (NotificationProfiler::isEnabled()) {
+                NotificationProfiler::recordSet(&this->_onChange, typeid(ValType), !changed);
+            }
+
             if (changed && notify) {
-                this->_onChange.notify(Backing<ValType>::shared_from_this());
+                this->notifyChange();
             }
         }
 
@@ -5,6 +5,11 @@
 #include <bdn/android/wrapper/Looper.h>
 #include <bdn/android/wrapper/NativeDispatcher.h>
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
 namespace bdn::android
 {
 
@@ -26,22 +31,24 @@ namespace bdn::android
       protected:
         void notifyWorker(LockType &lk) override;
         void newTimed(LockType &lk) override;
-        void createTimerInternal(std::chrono::duration<double> interval, std::function<bool()> timer) override;
+        TimerHandle createTimerInternal(std::chrono::duration<double> interval, TimerFunction timer) override;
+        void cancelTimed(uint64_t id) override;
 
       private:
         void scheduleCallAt(DispatchQueue::TimePoint at);
 
-      private:
-        wrapper::NativeDispatcher _nativeDispatcher;
-
       public:
         class Timer_
         {
           public:
-            Timer_(const std::function<bool()> &func) { _func = func; }
+            Timer_(TimerFunction func) : _func(std::move(func)) {}
 
             bool onEvent()
             {
+                if (_cancelled) {
+                    return false;
+                }
+
                 try {
                     return _func();
                 }
@@ -50,8 +57,23 @@ namespace bdn::android
                 return false;
             }
 
+            void cancel() { _cancelled = true; }
+
           private:
-            std::function<bool()> _func;
+            TimerFunction _func;
+            std::atomic<bool> _cancelled{false};
         };
+
+      private:
+        // Ids of native timers are tagged so that they can be told apart from
+        // the ids of the timers managed by DispatchQueue itself.
+        static constexpr uint64_t NativeTimerFlag = uint64_t(1) << 63;
+
+        wrapper::NativeDispatcher _nativeDispatcher;
+
+        std::mutex _nativeTimersMutex;
+        std::unordered_map<uint64_t, std::weak_ptr<Timer_>> _nativeTimers;
+        uint64_t _nextNativeTimerId = 1;
+        size_t _nativeTimersSweepSize = 16;
     };
 }
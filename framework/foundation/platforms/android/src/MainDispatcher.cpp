@@ -6,6 +6,7 @@
 
 #include <bdn/jni.h>
 
+#include <algorithm>
 #include <utility>
 
 using namespace std::chrono_literals;
@@ -42,10 +43,48 @@ namespace bdn::android
 
     void MainDispatcher::newTimed(DispatchQueue::LockType &lk) { scheduleCallAt(DispatchQueue::Clock::now()); }
 
-    void MainDispatcher::createTimerInternal(std::chrono::duration<double> interval, std::function<bool()> timer)
+    DispatchQueue::TimerHandle MainDispatcher::createTimerInternal(std::chrono::duration<double> interval,
+                                                                   TimerFunction timer)
     {
-        std::shared_ptr<Timer_> nativeTimer = std::make_shared<Timer_>(timer);
+        std::shared_ptr<Timer_> nativeTimer = std::make_shared<Timer_>(std::move(timer));
+
+        uint64_t id;
+        {
+            std::unique_lock<std::mutex> lk(_nativeTimersMutex);
+
+            // Timers that ran out are released by the java side, forget them
+            // from time to time.
+            if (_nativeTimers.size() >= _nativeTimersSweepSize) {
+                for (auto it = _nativeTimers.begin(); it != _nativeTimers.end();) {
+                    it = it->second.expired() ? _nativeTimers.erase(it) : std::next(it);
+                }
+                _nativeTimersSweepSize = std::max<size_t>(16, _nativeTimers.size() * 2);
+            }
+
+            id = NativeTimerFlag | _nextNativeTimerId++;
+            _nativeTimers[id] = nativeTimer;
+        }
+
         _nativeDispatcher.createTimer(interval, nativeTimer);
+        return makeTimerHandle(id);
+    }
+
+    void MainDispatcher::cancelTimed(uint64_t id)
+    {
+        if ((id & NativeTimerFlag) == 0) {
+            DispatchQueue::cancelTimed(id);
+            return;
+        }
+
+        std::unique_lock<std::mutex> lk(_nativeTimersMutex);
+        auto it = _nativeTimers.find(id);
+        if (it != _nativeTimers.end()) {
+            // The java side stops the timer the next time it fires
+            if (auto nativeTimer = it->second.lock()) {
+                nativeTimer->cancel();
+            }
+            _nativeTimers.erase(it);
+        }
     }
 
     void MainDispatcher::scheduleCallAt(TimePoint at)
@@ -26,13 +26,19 @@ namespace bdn::fk
       protected:
         void notifyWorker(LockType &lk) override;
         void newTimed(LockType &lk) override;
-        void createTimerInternal(std::chrono::duration<double> interval, std::function<bool()> timer) override;
+        TimerHandle createTimerInternal(std::chrono::duration<double> interval, TimerFunction timer) override;
+        void cancelTimed(uint64_t id) override;
 
       private:
         void scheduleCall();
         void scheduleCallAt(DispatchQueue::TimePoint at);
 
       private:
+        // Ids of native timers are tagged so that they can be told apart from
+        // the ids of the timers managed by DispatchQueue itself.
+        static constexpr uint64_t NativeTimerFlag = uint64_t(1) << 63;
+
         std::list<std::unique_ptr<DispatchTimer>> _timers;
+        uint64_t _nextTimerId = 1;
     };
 }
@@ -41,12 +41,17 @@ namespace bdn::fk
 
     void MainDispatcher::newTimed(DispatchQueue::LockType &lk) { scheduleCall(); }
 
-    void MainDispatcher::createTimerInternal(std::chrono::duration<double> interval, std::function<bool()> timer)
+    DispatchQueue::TimerHandle MainDispatcher::createTimerInternal(std::chrono::duration<double> interval,
+                                                                   TimerFunction timer)
     {
         DispatchQueue::LockType lk(queueMutex());
 
+        uint64_t id = NativeTimerFlag | _nextTimerId++;
         auto intervalInNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(interval);
-        _timers.emplace_back(std::make_unique<DispatchTimer>(shared_from_this(), timer, intervalInNanoseconds.count()));
+        _timers.emplace_back(
+            std::make_unique<DispatchTimer>(shared_from_this(), id, std::move(timer), intervalInNanoseconds.count()));
+
+        return makeTimerHandle(id);
     }
 
     void MainDispatcher::process()
@@ -76,9 +81,11 @@ namespace bdn::fk
     class DispatchTimer
     {
       public:
-        DispatchTimer(std::weak_ptr<MainDispatcher> dispatcher, std::function<bool()> timer,
+        DispatchTimer(std::weak_ptr<MainDispatcher> dispatcher, uint64_t id, DispatchQueue::TimerFunction timer,
                       long long intervalInNanoseconds)
-            : _dispatcher(dispatcher), _timer(timer)
+            : _dispatcher(dispatcher), _id(id),
+              // Blocks can only capture copyable objects
+              _timer(std::make_shared<DispatchQueue::TimerFunction>(std::move(timer)))
         {
             _source = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
             dispatch_time_t intervalStart = dispatch_walltime(NULL, intervalInNanoseconds);
@@ -86,8 +93,9 @@ namespace bdn::fk
             dispatch_source_set_timer(_source, intervalStart, (dispatch_time_t)intervalInNanoseconds,
                                       10 * 1000 * 1000); // 10 ms leeway
 
+            auto sharedTimer = _timer;
             dispatch_source_set_event_handler(_source, ^{
-              if (!timer()) {
+              if (!(*sharedTimer)()) {
                   cancel();
               }
             });
@@ -97,6 +105,8 @@ namespace bdn::fk
 
         ~DispatchTimer() { cancel(); }
 
+        uint64_t id() const { return _id; }
+
         void cancel()
         {
             if (_source) {
@@ -111,6 +121,22 @@ namespace bdn::fk
       private:
         dispatch_source_t _source = nullptr;
         std::weak_ptr<MainDispatcher> _dispatcher;
-        std::function<bool()> _timer;
+        uint64_t _id;
+        std::shared_ptr<DispatchQueue::TimerFunction> _timer;
     };
+
+    void MainDispatcher::cancelTimed(uint64_t id)
+    {
+        if ((id & NativeTimerFlag) == 0) {
+            DispatchQueue::cancelTimed(id);
+            return;
+        }
+
+        DispatchQueue::LockType lk(queueMutex());
+        auto it = std::find_if(_timers.begin(), _timers.end(), [id](auto &p) { return p->id() == id; });
+        if (it != _timers.end()) {
+            // Removes the timer from _timers via timerFinished()
+            (*it)->cancel();
+        }
+    }
 }
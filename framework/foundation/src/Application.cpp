@@ -1,5 +1,6 @@
 
 #include <bdn/Application.h>
+#include <bdn/NotificationProfiler.h>
 #include <bdn/debug.h>
 #include <bdn/log.h>
 
@@ -79,6 +80,10 @@ namespace bdn
         // get a crash.
         disposeMainDispatcher();
 
+        if (NotificationProfiler::isEnabled()) {
+            logstream() << NotificationProfiler::report();
+        }
+
         platformSpecificCleanup();
 
         setGlobalApplication(nullptr);
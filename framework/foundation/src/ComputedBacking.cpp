@@ -0,0 +1,87 @@
+#include <bdn/property/ComputedBacking.h>
+
+#include <map>
+#include <mutex>
+
+namespace bdn::detail
+{
+    namespace
+    {
+        std::mutex s_sourceNodesMutex;
+
+        // Weak pointers compare by control block, so a destroyed backing
+        // cannot be confused with a new one at the same address.
+        std::map<std::weak_ptr<const void>, std::weak_ptr<ComputedSourceNode>, std::owner_less<>> s_sourceNodes;
+    }
+
+    void ComputedNode::addDependent(ComputedNode *dependent) { _dependents.push_back(dependent); }
+
+    void ComputedNode::removeDependent(ComputedNode *dependent)
+    {
+        _dependents.erase(std::remove(_dependents.begin(), _dependents.end(), dependent), _dependents.end());
+    }
+
+    void ComputedNode::sourceChanged()
+    {
+        static thread_local uint64_t lastPropagation = 0;
+
+        std::vector<std::pair<size_t, std::weak_ptr<ComputedNode>>> invalidated;
+        invalidate(++lastPropagation, invalidated);
+
+        std::stable_sort(invalidated.begin(), invalidated.end(),
+                         [](const auto &a, const auto &b) { return a.first < b.first; });
+
+        for (auto &entry : invalidated) {
+            if (auto node = entry.second.lock()) {
+                node->notifyDependents();
+            }
+        }
+    }
+
+    void ComputedNode::invalidate(uint64_t propagation,
+                                  std::vector<std::pair<size_t, std::weak_ptr<ComputedNode>>> &invalidated)
+    {
+        if (_propagation == propagation) {
+            return;
+        }
+        _propagation = propagation;
+        _dirty = true;
+
+        auto node = weakNode();
+        if (!node.expired()) {
+            invalidated.emplace_back(_level, std::move(node));
+        }
+
+        for (auto dependent : _dependents) {
+            dependent->invalidate(propagation, invalidated);
+        }
+    }
+
+    ComputedSourceNode::~ComputedSourceNode()
+    {
+        _disconnect();
+
+        std::lock_guard lock(s_sourceNodesMutex);
+        auto it = s_sourceNodes.find(_backing);
+        if (it != s_sourceNodes.end() && it->second.expired()) {
+            s_sourceNodes.erase(it);
+        }
+    }
+
+    std::shared_ptr<ComputedSourceNode> ComputedSourceNode::forBacking(const std::shared_ptr<const void> &backing,
+                                                                       const Connect &connect)
+    {
+        std::lock_guard lock(s_sourceNodesMutex);
+
+        auto &entry = s_sourceNodes[backing];
+        if (auto node = entry.lock()) {
+            return node;
+        }
+
+        auto node = std::make_shared<ComputedSourceNode>();
+        node->_backing = backing;
+        node->_disconnect = connect(node.get());
+        entry = node;
+        return node;
+    }
+}
@@ -0,0 +1,226 @@
+#include <bdn/ConcurrentDispatchQueue.h>
+
+#include <algorithm>
+#include <future>
+
+namespace bdn
+{
+    namespace
+    {
+        struct CurrentWorker
+        {
+            const ConcurrentDispatchQueue *queue = nullptr;
+            size_t index = 0;
+        };
+
+        thread_local CurrentWorker t_currentWorker;
+    }
+
+    ConcurrentDispatchQueue::ConcurrentDispatchQueue(size_t numberOfWorkers)
+    {
+        if (numberOfWorkers == 0) {
+            numberOfWorkers = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        _workers.reserve(numberOfWorkers);
+        for (size_t i = 0; i < numberOfWorkers; i++) {
+            _workers.emplace_back(std::make_unique<Worker>());
+        }
+
+        // Only start the threads once all workers exist, since they start
+        // stealing from each other right away.
+        for (size_t i = 0; i < numberOfWorkers; i++) {
+            _workers[i]->thread = std::thread(&ConcurrentDispatchQueue::workerThread, this, i);
+        }
+    }
+
+    ConcurrentDispatchQueue::~ConcurrentDispatchQueue()
+    {
+        cancel();
+
+        for (auto &worker : _workers) {
+            if (worker->thread.joinable()) {
+                worker->thread.join();
+            }
+        }
+    }
+
+    void ConcurrentDispatchQueue::dispatchAsync(Function function)
+    {
+        if (_cancelled) {
+            return;
+        }
+
+        if (auto index = currentWorkerIndex()) {
+            push(*index, std::move(function));
+        } else {
+            push(_nextWorker++ % _workers.size(), std::move(function));
+        }
+    }
+
+    void ConcurrentDispatchQueue::dispatchSync(Function function)
+    {
+        if (currentWorkerIndex()) {
+            function();
+            return;
+        }
+
+        if (_cancelled) {
+            return;
+        }
+
+        std::packaged_task<void()> task(std::move(function));
+        auto future = task.get_future();
+
+        dispatchAsync([task = std::move(task)]() mutable { task(); });
+
+        // Like DispatchQueue::dispatchSync, rethrow the function's exceptions.
+        // If the queue is cancelled before the task ran, the task is destroyed
+        // together with the pending functions, which breaks the promise.
+        try {
+            future.get();
+        }
+        catch (const std::future_error &error) {
+            if (error.code() != std::future_errc::broken_promise) {
+                throw;
+            }
+        }
+    }
+
+    void ConcurrentDispatchQueue::cancel()
+    {
+        _cancelled = true;
+
+        for (auto &worker : _workers) {
+            std::deque<Function> dropped;
+            {
+                std::unique_lock<std::mutex> lk(worker->mutex);
+                dropped.swap(worker->functions);
+            }
+        }
+
+        {
+            std::unique_lock<std::mutex> lk(_idleMutex);
+            _idleNotification.notify_all();
+        }
+
+        _timedQueue.cancel();
+    }
+
+    ConcurrentDispatchQueue::TimerHandle ConcurrentDispatchQueue::createTimerInternal(std::chrono::nanoseconds interval,
+                                                                                      TimerFunction timer)
+    {
+        struct SharedTimer
+        {
+            TimerFunction function;
+            std::atomic<bool> busy{false};
+            std::atomic<bool> finished{false};
+        };
+
+        auto sharedTimer = std::make_shared<SharedTimer>();
+        sharedTimer->function = std::move(timer);
+
+        // The timer itself lives on the timed queue, so that the handle stays
+        // valid for its whole lifetime. It only hands the calls to the workers.
+        return _timedQueue.createTimer(interval, [this, sharedTimer]() {
+            if (sharedTimer->finished) {
+                return false;
+            }
+
+            if (!sharedTimer->busy.exchange(true)) {
+                dispatchAsync([sharedTimer]() {
+                    if (!sharedTimer->function()) {
+                        sharedTimer->finished = true;
+                    }
+                    sharedTimer->busy = false;
+                });
+            }
+            return true;
+        });
+    }
+
+    void ConcurrentDispatchQueue::push(size_t workerIndex, Function function)
+    {
+        {
+            auto &worker = *_workers[workerIndex];
+            std::unique_lock<std::mutex> lk(worker.mutex);
+
+            // Checked under the worker's mutex so that nothing can be added
+            // after cancel() has emptied the deque.
+            if (_cancelled) {
+                return;
+            }
+
+            worker.functions.push_back(std::move(function));
+            _pending++;
+        }
+
+        // Only pay for the notification if a worker might actually be waiting
+        if (_idleWorkers > 0) {
+            std::unique_lock<std::mutex> lk(_idleMutex);
+            _idleNotification.notify_one();
+        }
+    }
+
+    bool ConcurrentDispatchQueue::popOwn(size_t workerIndex, Function &function)
+    {
+        auto &worker = *_workers[workerIndex];
+        std::unique_lock<std::mutex> lk(worker.mutex);
+        if (worker.functions.empty()) {
+            return false;
+        }
+
+        // The owner takes the most recently pushed function, since that is
+        // the one most likely to still be hot in the cache.
+        function = std::move(worker.functions.back());
+        worker.functions.pop_back();
+        _pending--;
+        return true;
+    }
+
+    bool ConcurrentDispatchQueue::steal(size_t thiefIndex, Function &function)
+    {
+        for (size_t i = 1; i < _workers.size(); i++) {
+            auto &victim = *_workers[(thiefIndex + i) % _workers.size()];
+
+            std::unique_lock<std::mutex> lk(victim.mutex);
+            if (victim.functions.empty()) {
+                continue;
+            }
+
+            // Thieves take the oldest function from the other end of the deque
+            function = std::move(victim.functions.front());
+            victim.functions.pop_front();
+            _pending--;
+            return true;
+        }
+        return false;
+    }
+
+    void ConcurrentDispatchQueue::workerThread(size_t workerIndex)
+    {
+        t_currentWorker = CurrentWorker{this, workerIndex};
+
+        Function function;
+        while (!_cancelled) {
+            if (popOwn(workerIndex, function) || steal(workerIndex, function)) {
+                function();
+                function = nullptr;
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lk(_idleMutex);
+            _idleWorkers++;
+            _idleNotification.wait(lk, [this]() { return _cancelled || _pending > 0; });
+            _idleWorkers--;
+        }
+    }
+
+    std::optional<size_t> ConcurrentDispatchQueue::currentWorkerIndex() const
+    {
+        if (t_currentWorker.queue == this) {
+            return t_currentWorker.index;
+        }
+        return std::nullopt;
+    }
+}
@@ -0,0 +1,158 @@
+#include <bdn/Json.h>
+#include <bdn/NotificationProfiler.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#if defined(__GNUG__)
+#include <cstdlib>
+#include <cxxabi.h>
+#include <memory>
+#endif
+
+namespace bdn
+{
+    namespace
+    {
+        std::mutex s_entriesMutex;
+        std::unordered_map<const void *, NotificationProfiler::Entry> s_entries;
+
+        std::string typeName(const std::type_info &type)
+        {
+#if defined(__GNUG__)
+            int status = 0;
+            std::unique_ptr<char, void (*)(void *)> demangled(
+                abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), std::free);
+            if (status == 0 && demangled) {
+                return demangled.get();
+            }
+#endif
+            return type.name();
+        }
+
+        NotificationProfiler::Entry &entryFor(const void *source)
+        {
+            auto &entry = s_entries[source];
+            entry.source = source;
+            return entry;
+        }
+
+        std::string displayName(const NotificationProfiler::Entry &entry)
+        {
+            if (!entry.name.empty()) {
+                return entry.name;
+            }
+            std::ostringstream s;
+            s << entry.type << " @" << entry.source;
+            return s.str();
+        }
+    }
+
+    void NotificationProfiler::setEnabled(bool enabled) { s_enabled = enabled; }
+
+    void NotificationProfiler::reset()
+    {
+        std::lock_guard lock(s_entriesMutex);
+        s_entries.clear();
+    }
+
+    void NotificationProfiler::setName(const void *source, std::string name)
+    {
+        std::lock_guard lock(s_entriesMutex);
+        entryFor(source).name = std::move(name);
+    }
+
+    void NotificationProfiler::recordNotify(const void *source, const std::type_info &type, size_t subscribers,
+                                            std::chrono::nanoseconds callbackTime)
+    {
+        std::lock_guard lock(s_entriesMutex);
+        auto &entry = entryFor(source);
+        if (entry.type.empty()) {
+            entry.type = typeName(type);
+        }
+        entry.notifications++;
+        entry.subscriberCalls += subscribers;
+        entry.maxSubscribers = std::max(entry.maxSubscribers, subscribers);
+        entry.callbackTime += callbackTime;
+    }
+
+    void NotificationProfiler::recordSet(const void *source, const std::type_info &type, bool redundant)
+    {
+        std::lock_guard lock(s_entriesMutex);
+        auto &entry = entryFor(source);
+        // The value type tells more than the type of the notifier
+        if (entry.sets == 0) {
+            entry.type = typeName(type);
+        }
+        entry.sets++;
+        if (redundant) {
+            entry.redundantSets++;
+        }
+    }
+
+    std::vector<NotificationProfiler::Entry> NotificationProfiler::entries()
+    {
+        std::vector<Entry> result;
+        {
+            std::lock_guard lock(s_entriesMutex);
+            result.reserve(s_entries.size());
+            for (const auto &entry : s_entries) {
+                result.push_back(entry.second);
+            }
+        }
+
+        std::sort(result.begin(), result.end(), [](const Entry &a, const Entry &b) {
+            if (a.callbackTime != b.callbackTime) {
+                return a.callbackTime > b.callbackTime;
+            }
+            return a.notifications > b.notifications;
+        });
+        return result;
+    }
+
+    std::string NotificationProfiler::toJson()
+    {
+        json result = json::array();
+        for (const auto &entry : entries()) {
+            std::ostringstream address;
+            address << entry.source;
+
+            result.push_back({{"source", address.str()},
+                              {"name", entry.name},
+                              {"type", entry.type},
+                              {"notifications", entry.notifications},
+                              {"subscriberCalls", entry.subscriberCalls},
+                              {"maxSubscribers", entry.maxSubscribers},
+                              {"callbackTimeNs", entry.callbackTime.count()},
+                              {"sets", entry.sets},
+                              {"redundantSets", entry.redundantSets}});
+        }
+        return result.dump(2);
+    }
+
+    std::string NotificationProfiler::report(size_t count)
+    {
+        auto all = entries();
+
+        std::ostringstream s;
+        s << "Notification profile, top " << std::min(count, all.size()) << " of " << all.size() << " sources:\n";
+        s << std::setw(12) << "time (us)" << std::setw(10) << "notifies" << std::setw(10) << "fan-out" << std::setw(10)
+          << "max" << std::setw(10) << "sets" << std::setw(10) << "redundant"
+          << "  source\n";
+
+        for (size_t i = 0; i < count && i < all.size(); i++) {
+            const auto &entry = all[i];
+            double averageFanOut =
+                entry.notifications > 0 ? double(entry.subscriberCalls) / double(entry.notifications) : 0.0;
+
+            s << std::setw(12) << std::chrono::duration_cast<std::chrono::microseconds>(entry.callbackTime).count()
+              << std::setw(10) << entry.notifications << std::setw(10) << std::fixed << std::setprecision(1)
+              << averageFanOut << std::setw(10) << entry.maxSubscribers << std::setw(10) << entry.sets << std::setw(10)
+              << entry.redundantSets << "  " << displayName(entry) << "\n";
+        }
+        return s.str();
+    }
+}
@@ -0,0 +1,12 @@
+#include <bdn/Notifier.h>
+
+#include <atomic>
+
+namespace bdn
+{
+    uint64_t NotifierSubscription::nextId()
+    {
+        static std::atomic<uint64_t> lastId{0};
+        return ++lastId;
+    }
+}
@@ -0,0 +1,80 @@
+#include <bdn/log.h>
+#include <bdn/property/PropertyTransaction.h>
+
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace bdn
+{
+    namespace
+    {
+        struct TransactionState
+        {
+            int depth = 0;
+            std::vector<UniqueFunction<void()>> pending;
+
+            // Weak pointers compare by control block, so an owner that is
+            // destroyed during the transaction cannot be confused with a new
+            // object at the same address.
+            std::set<std::weak_ptr<const void>, std::owner_less<>> pendingOwners;
+        };
+
+        thread_local TransactionState t_transaction;
+    }
+
+    PropertyTransaction::PropertyTransaction() { t_transaction.depth++; }
+
+    PropertyTransaction::~PropertyTransaction()
+    {
+        logAndIgnoreException([this]() { commit(); }, "Exception while delivering property notifications");
+    }
+
+    void PropertyTransaction::commit()
+    {
+        if (_committed) {
+            return;
+        }
+        _committed = true;
+
+        auto &state = t_transaction;
+        if (state.depth > 1) {
+            state.depth--;
+            return;
+        }
+
+        // Stay active while delivering, so that changes made by subscribers
+        // are collapsed into the next pass instead of notifying one by one.
+        struct DepthGuard
+        {
+            ~DepthGuard()
+            {
+                // If a subscriber threw, the rest of the batch is dropped
+                if (--t_transaction.depth == 0) {
+                    t_transaction.pending.clear();
+                    t_transaction.pendingOwners.clear();
+                }
+            }
+        } guard;
+
+        while (!state.pending.empty()) {
+            auto pending = std::move(state.pending);
+            state.pending.clear();
+            state.pendingOwners.clear();
+
+            for (auto &notify : pending) {
+                notify();
+            }
+        }
+    }
+
+    bool PropertyTransaction::isActive() { return t_transaction.depth > 0; }
+
+    void PropertyTransaction::defer(const std::shared_ptr<const void> &owner, UniqueFunction<void()> notify)
+    {
+        auto &state = t_transaction;
+        if (state.pendingOwners.insert(owner).second) {
+            state.pending.push_back(std::move(notify));
+        }
+    }
+}
@@ -8,10 +8,10 @@ namespace bdn
       public:
         TimerImpl(Timer *timer) : _timer(timer) {}
 
-        bool notify(size_t id)
+        bool notify()
         {
             std::unique_lock<std::mutex> lk(_mutex);
-            if (_timer && _timer->currentId() == id) {
+            if (_timer) {
                 _timer->onTriggered().notify();
                 return true;
             }
@@ -32,19 +32,18 @@ namespace bdn
     class TimerCallback
     {
       public:
-        TimerCallback(std::weak_ptr<TimerImpl> timer, size_t id) : _timer(std::move(timer)), _id(id) {}
+        TimerCallback(std::weak_ptr<TimerImpl> timer) : _timer(std::move(timer)) {}
 
         bool operator()() const
         {
             if (auto timer = _timer.lock()) {
-                return timer->notify(_id);
+                return timer->notify();
             }
             return false;
         }
 
       private:
         std::weak_ptr<TimerImpl> _timer;
-        size_t _id;
     };
 
     Timer::Timer(std::shared_ptr<DispatchQueue> dispatchQueue)
@@ -98,12 +97,12 @@ namespace bdn
     {
         if (!_isRunning) {
             if (!repeat) {
-                TimerCallback tc(_impl, ++_id);
-                _dispatchQueue->dispatchAsyncDelayed(
+                TimerCallback tc(_impl);
+                _handle = _dispatchQueue->dispatchAsyncDelayed(
                     std::chrono::duration_cast<std::chrono::milliseconds>(interval.get()), [tc]() { tc(); });
             } else {
-                _dispatchQueue->createTimer(std::chrono::duration_cast<std::chrono::milliseconds>(interval.get()),
-                                            TimerCallback{_impl, ++_id});
+                _handle = _dispatchQueue->createTimer(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(interval.get()), TimerCallback{_impl});
             }
 
             _isRunning = true;
@@ -114,7 +113,7 @@ namespace bdn
     void Timer::stop()
     {
         running = false;
-        _id++;
+        _handle.cancel();
         _isRunning = false;
     }
 
@@ -123,6 +122,4 @@ namespace bdn
         stop();
         start();
     }
-
-    size_t Timer::currentId() { return _id; }
 }
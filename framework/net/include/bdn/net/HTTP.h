@@ -1,6 +1,9 @@
 #pragma once
 
+#include <bdn/Future.h>
+
 #include <memory>
+#include <string>
 
 namespace bdn::net
 {
@@ -22,5 +25,14 @@ namespace bdn::net
         };
 
         void request(HTTPRequest request);
+
+        /** Sends a request and returns a future for its response. The future
+            is completed on the application's dispatch queue, if the request
+            cannot be sent it fails with a broken_promise std::future_error.
+
+            With coroutines enabled the result can be awaited directly:
+            `auto response = co_await http::fetch(http::Method::GET, url);`
+         */
+        Future<std::shared_ptr<HTTPResponse>> fetch(Method method, std::string url);
     }
 }
@@ -0,0 +1,19 @@
+#include <bdn/net/HTTP.h>
+#include <bdn/net/HTTPRequest.h>
+#include <bdn/net/HTTPResponse.h>
+
+namespace bdn::net::http
+{
+    Future<std::shared_ptr<HTTPResponse>> fetch(Method method, std::string url)
+    {
+        // The done handler has to be copyable
+        auto promise = std::make_shared<Promise<std::shared_ptr<HTTPResponse>>>();
+        auto future = promise->future();
+
+        request(HTTPRequest(method, std::move(url), [promise](std::shared_ptr<HTTPResponse> response) {
+            promise->setValue(std::move(response));
+        }));
+
+        return future;
+    }
+}
@@ -129,7 +129,7 @@ namespace bdn::ui
 
             std::shared_ptr<ViewCoreFactory> viewCoreFactory() { return _viewCoreFactory; }
 
-            virtual void updateFromStylesheet(json stylesheet) {}
+            virtual void updateFromStylesheet(const json &stylesheet) {}
 
           protected:
             static void setParentViewOfView(const std::shared_ptr<View> &view, const std::shared_ptr<View> &parentView)
@@ -145,7 +145,7 @@ namespace bdn::ui::yoga
                    flexBasis == other.flexBasis && flexGrow == other.flexGrow && flexShrink == other.flexShrink &&
                    padding == other.padding && margin == other.margin && size == other.size &&
                    minimumSize == other.minimumSize && maximumSize == other.maximumSize && position == other.position &&
-                   positionType != other.positionType;
+                   positionType == other.positionType && aspectRatio == other.aspectRatio;
         }
     };
 }
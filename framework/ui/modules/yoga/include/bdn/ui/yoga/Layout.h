@@ -2,7 +2,8 @@
 
 #include <bdn/ui/yoga/ViewData.h>
 
-#include <map>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace bdn::ui::yoga
 {
@@ -15,15 +16,27 @@ namespace bdn::ui::yoga
         void markDirty(View *view) override;
         void updateStylesheet(View *view) override;
 
+        /** Lays out view if it is a layout root, together with all other
+            dirty layout roots of this Layout. The resulting geometry is
+            applied in one PropertyTransaction.
+         */
         void layout(View *view) override;
 
       private:
-        void applyStyle(View *view, YGNodeRef ygNode);
+        void applyStyle(View *view, ViewData &viewData);
 
         void insert(View *view);
         void remove(View *view);
 
+        void updateChildOrder(ViewData &viewData, View *parent);
+        static uint32_t childPosition(YGNodeRef parentNode, uint64_t childOrder);
+
+        static size_t treeDepth(YGNodeRef node);
+
       private:
-        std::map<View *, std::unique_ptr<ViewData>> _views;
+        std::unordered_map<View *, std::unique_ptr<ViewData>> _views;
+        uint64_t _lastChildOrder = 0;
+
+        std::unordered_set<ViewData *> _roots;
     };
 }
@@ -4,20 +4,40 @@
 #include <bdn/Rect.h>
 #include <bdn/property/Property.h>
 #include <bdn/ui/View.h>
+#include <bdn/ui/yoga/FlexStylesheet.h>
 #include <yoga/Yoga.h>
 
+#include <array>
+#include <cstdint>
+#include <optional>
+
 struct YGNode;
 
 namespace bdn::ui::yoga
 {
     class ViewData
     {
+      public:
+        /** Hit and miss counts of the measurement caches of all views */
+        struct MeasureCacheStatistics
+        {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+
+            double hitRate() const { return hits + misses > 0 ? double(hits) / double(hits + misses) : 0.0; }
+        };
+
       public:
         ViewData(View *v);
         ~ViewData();
 
         void doLayout();
 
+        /** The two steps of doLayout(), for laying out several roots in one
+            PropertyTransaction. */
+        void calculateLayout();
+        void applyCalculatedLayout();
+
         static void onDirtied(YGNodeRef node);
 
         static YGSize measureFunc(YGNodeRef node, float width, YGMeasureMode widthMode, float height,
@@ -32,6 +52,13 @@ namespace bdn::ui::yoga
 
         void childrenChanged(bool adding = false);
 
+        /** Invalidates the cached measurements, called if the content of the
+            view changed (see View::Core::markDirty()). */
+        void contentChanged() { contentGeneration++; }
+
+        static MeasureCacheStatistics measureCacheStatistics();
+        static void resetMeasureCacheStatistics();
+
       public:
         Property<Rect> geometry;
 
@@ -40,5 +67,33 @@ namespace bdn::ui::yoga
         std::function<void()> layoutFunction;
         bool isRootNode;
         bool isIn;
+        bool hasLayout = false;
+
+        // Children can only be appended to a parent, so the order in which
+        // they were first seen with their parent is their order among the
+        // siblings. The yoga children of a node are sorted by it.
+        uint64_t childOrder = 0;
+        View *childOrderParent = nullptr;
+
+        // The "flex" part of the stylesheet last applied to ygNode
+        json flexJson;
+        std::optional<FlexStylesheet> flexStylesheet;
+
+        // Yoga measures a leaf several times per pass and drops its own cache
+        // whenever the node is dirtied, e.g. by a style change. The results
+        // of View::sizeForSpace stay valid until the content changes.
+        struct MeasureCacheEntry
+        {
+            float width;
+            YGMeasureMode widthMode;
+            float height;
+            YGMeasureMode heightMode;
+            uint64_t contentGeneration = 0;
+            YGSize size;
+        };
+
+        uint64_t contentGeneration = 1;
+        std::array<MeasureCacheEntry, 4> measureCache{};
+        size_t nextMeasureCacheEntry = 0;
     };
 }
@@ -1,9 +1,13 @@
+#include <bdn/property/PropertyTransaction.h>
 #include <bdn/ui/View.h>
 #include <bdn/ui/yoga/FlexStylesheet.h>
 #include <bdn/ui/yoga/Layout.h>
 
 #include <yoga/YGNode.h>
 
+#include <algorithm>
+#include <vector>
+
 namespace bdn::ui::yoga
 {
     constexpr YGFlexDirection toYGFlexDirection(FlexStylesheet::Direction direction)
@@ -104,14 +108,29 @@ namespace bdn::ui::yoga
 
     void Layout::registerView(View *view)
     {
-        _views[view] = std::make_unique<ViewData>(view);
+        auto &viewData = _views[view];
+        viewData = std::make_unique<ViewData>(view);
+        updateChildOrder(*viewData, view->parentView->lock().get());
+
+        if (viewData->isRootNode) {
+            _roots.insert(viewData.get());
+        }
+
         updateStylesheet(view);
+
+        // Children that joined the layout before their parent did
+        for (const auto &child : view->childViews()) {
+            if (auto it = _views.find(child.get()); it != _views.end() && !it->second->isIn && child->visible.get()) {
+                insert(child.get());
+            }
+        }
     }
 
     void Layout::unregisterView(View *view)
     {
         remove(view);
         if (auto it = _views.find(view); it != _views.end()) {
+            _roots.erase(it->second.get());
             _views.erase(it);
         }
     }
@@ -119,6 +138,7 @@ namespace bdn::ui::yoga
     void Layout::markDirty(View *view)
     {
         if (auto it = _views.find(view); it != _views.end()) {
+            it->second->contentChanged();
             it->second->ygNode->markDirtyAndPropogate();
         }
     }
@@ -126,26 +146,59 @@ namespace bdn::ui::yoga
     void Layout::updateStylesheet(View *view)
     {
         if (auto it = _views.find(view); it != _views.end()) {
-            applyStyle(view, it->second->ygNode);
+            applyStyle(view, *it->second);
         }
     }
 
     void Layout::layout(View *view)
     {
-        if (auto it = _views.find(view); it != _views.end()) {
-            it->second->doLayout();
+        auto it = _views.find(view);
+        if (it == _views.end() || !it->second->isRootNode) {
+            return;
         }
-    }
 
-    FlexStylesheet fromStyleSheet(const json &jsonStyleSheet)
-    {
-        FlexStylesheet result;
+        auto &viewData = *it->second;
+
+        // Already laid out together with another root
+        if (viewData.hasLayout && !YGNodeIsDirty(viewData.ygNode)) {
+            return;
+        }
+
+        std::vector<ViewData *> dirtyRoots{&viewData};
+        for (auto root : _roots) {
+            if (root != &viewData && YGNodeIsDirty(root->ygNode)) {
+                dirtyRoots.push_back(root);
+            }
+        }
+
+        // A root nested in another root's yoga tree is calculated with it, so
+        // calculate outer roots first
+        std::stable_sort(dirtyRoots.begin(), dirtyRoots.end(),
+                         [](ViewData *a, ViewData *b) { return treeDepth(a->ygNode) < treeDepth(b->ygNode); });
+
+        for (auto root : dirtyRoots) {
+            root->calculateLayout();
+        }
 
-        if (jsonStyleSheet.count("flex")) {
-            result = (FlexStylesheet)jsonStyleSheet.at("flex");
+        // Deliver the geometry changes once all roots are updated
+        PropertyTransaction transaction;
+        for (auto root : dirtyRoots) {
+            root->applyCalculatedLayout();
         }
+        transaction.commit();
 
-        return result;
+        for (auto root : dirtyRoots) {
+            root->ygNode->setDirty(false);
+        }
+    }
+
+    size_t Layout::treeDepth(YGNodeRef node)
+    {
+        size_t depth = 0;
+        while ((node = YGNodeGetOwner(node)) != nullptr) {
+            depth++;
+        }
+        return depth;
     }
 
 #define UPDATE_VALUE(FuncName, Value, ...)                                                                             \
@@ -171,51 +224,118 @@ namespace bdn::ui::yoga
     UPDATE_VALUE(FuncName##Width, Value.width, Node)                                                                   \
     UPDATE_VALUE(FuncName##Height, Value.height, Node)
 
-    void Layout::applyStyle(View *view, YGNodeRef ygNode)
-    {
-        FlexStylesheet stylesheet = fromStyleSheet(view->stylesheet.get());
+#define STYLE_CHANGED(Field) (previous == nullptr || !(previous->Field == stylesheet.Field))
 
+    void Layout::applyStyle(View *view, ViewData &viewData)
+    {
         if (view->visible.get()) {
             insert(view);
         } else {
             remove(view);
         }
 
-        YGNodeStyleSetFlexDirection(ygNode, toYGFlexDirection(stylesheet.flexDirection));
-        YGNodeStyleSetDirection(ygNode, toYGDirection(stylesheet.layoutDirection));
+        // Most stylesheet changes do not touch "flex", so only parse it if it
+        // differs from the cached one. Then only pass changed values to yoga,
+        // which marks the node dirty even when an unset (NAN) value is reset.
+        bool flexChanged = view->stylesheet.read([&viewData](const json &sheet) {
+            static const json noFlex = json::object();
 
-        YGNodeStyleSetAlignContent(ygNode, toYGAlign(stylesheet.alignContents));
-        YGNodeStyleSetAlignItems(ygNode, toYGAlign(stylesheet.alignItems));
-        YGNodeStyleSetAlignSelf(ygNode, toYGAlign(stylesheet.alignSelf));
+            auto it = sheet.find("flex");
+            const json &flex = it != sheet.end() ? *it : noFlex;
+
+            if (viewData.flexStylesheet && viewData.flexJson == flex) {
+                return false;
+            }
 
-        YGNodeStyleSetJustifyContent(ygNode, toYGJustify(stylesheet.justifyContent));
+            viewData.flexJson = flex;
+            return true;
+        });
 
-        YGNodeStyleSetFlexWrap(ygNode, toYGWrap(stylesheet.flexWrap));
+        if (!flexChanged) {
+            return;
+        }
 
-        YGNodeStyleSetFlexGrow(ygNode, stylesheet.flexGrow);
-        YGNodeStyleSetFlexShrink(ygNode, stylesheet.flexShrink);
+        auto stylesheet = viewData.flexJson.get<FlexStylesheet>();
+        if (viewData.flexStylesheet && *viewData.flexStylesheet == stylesheet) {
+            return;
+        }
 
-        UPDATE_EDGES(YGNodeStyleSetPadding, ygNode, stylesheet.padding)
-        UPDATE_EDGES(YGNodeStyleSetMargin, ygNode, stylesheet.margin)
-        UPDATE_EDGES(YGNodeStyleSetPosition, ygNode, stylesheet.position)
+        const FlexStylesheet *previous = viewData.flexStylesheet ? &*viewData.flexStylesheet : nullptr;
+        YGNodeRef ygNode = viewData.ygNode;
 
-        UPDATE_SIZES(YGNodeStyleSet, ygNode, stylesheet.size)
-        UPDATE_SIZES(YGNodeStyleSetMin, ygNode, stylesheet.minimumSize)
-        UPDATE_SIZES(YGNodeStyleSetMax, ygNode, stylesheet.maximumSize)
+        if (STYLE_CHANGED(flexDirection)) {
+            YGNodeStyleSetFlexDirection(ygNode, toYGFlexDirection(stylesheet.flexDirection));
+        }
+        if (STYLE_CHANGED(layoutDirection)) {
+            YGNodeStyleSetDirection(ygNode, toYGDirection(stylesheet.layoutDirection));
+        }
 
-        YGNodeStyleSetPositionType(ygNode, toYGPositionType(stylesheet.positionType));
+        if (STYLE_CHANGED(alignContents)) {
+            YGNodeStyleSetAlignContent(ygNode, toYGAlign(stylesheet.alignContents));
+        }
+        if (STYLE_CHANGED(alignItems)) {
+            YGNodeStyleSetAlignItems(ygNode, toYGAlign(stylesheet.alignItems));
+        }
+        if (STYLE_CHANGED(alignSelf)) {
+            YGNodeStyleSetAlignSelf(ygNode, toYGAlign(stylesheet.alignSelf));
+        }
 
-        YGNodeStyleSetAspectRatio(ygNode, stylesheet.aspectRatio ? *stylesheet.aspectRatio : NAN);
+        if (STYLE_CHANGED(justifyContent)) {
+            YGNodeStyleSetJustifyContent(ygNode, toYGJustify(stylesheet.justifyContent));
+        }
 
-        if (!stylesheet.flexBasis) {
-            YGNodeStyleSetFlexBasisAuto(ygNode);
-        } else {
-            if (stylesheet.flexBasis->isPercent()) {
-                YGNodeStyleSetFlexBasisPercent(ygNode, stylesheet.flexBasis->value);
+        if (STYLE_CHANGED(flexWrap)) {
+            YGNodeStyleSetFlexWrap(ygNode, toYGWrap(stylesheet.flexWrap));
+        }
+
+        if (STYLE_CHANGED(flexGrow)) {
+            YGNodeStyleSetFlexGrow(ygNode, stylesheet.flexGrow);
+        }
+        if (STYLE_CHANGED(flexShrink)) {
+            YGNodeStyleSetFlexShrink(ygNode, stylesheet.flexShrink);
+        }
+
+        if (STYLE_CHANGED(padding)) {
+            UPDATE_EDGES(YGNodeStyleSetPadding, ygNode, stylesheet.padding)
+        }
+        if (STYLE_CHANGED(margin)) {
+            UPDATE_EDGES(YGNodeStyleSetMargin, ygNode, stylesheet.margin)
+        }
+        if (STYLE_CHANGED(position)) {
+            UPDATE_EDGES(YGNodeStyleSetPosition, ygNode, stylesheet.position)
+        }
+
+        if (STYLE_CHANGED(size)) {
+            UPDATE_SIZES(YGNodeStyleSet, ygNode, stylesheet.size)
+        }
+        if (STYLE_CHANGED(minimumSize)) {
+            UPDATE_SIZES(YGNodeStyleSetMin, ygNode, stylesheet.minimumSize)
+        }
+        if (STYLE_CHANGED(maximumSize)) {
+            UPDATE_SIZES(YGNodeStyleSetMax, ygNode, stylesheet.maximumSize)
+        }
+
+        if (STYLE_CHANGED(positionType)) {
+            YGNodeStyleSetPositionType(ygNode, toYGPositionType(stylesheet.positionType));
+        }
+
+        if (STYLE_CHANGED(aspectRatio)) {
+            YGNodeStyleSetAspectRatio(ygNode, stylesheet.aspectRatio ? *stylesheet.aspectRatio : NAN);
+        }
+
+        if (STYLE_CHANGED(flexBasis)) {
+            if (!stylesheet.flexBasis) {
+                YGNodeStyleSetFlexBasisAuto(ygNode);
             } else {
-                YGNodeStyleSetFlexBasis(ygNode, stylesheet.flexBasis->value);
+                if (stylesheet.flexBasis->isPercent()) {
+                    YGNodeStyleSetFlexBasisPercent(ygNode, stylesheet.flexBasis->value);
+                } else {
+                    YGNodeStyleSetFlexBasis(ygNode, stylesheet.flexBasis->value);
+                }
             }
         }
+
+        viewData.flexStylesheet = std::move(stylesheet);
     }
 
     void Layout::insert(View *view)
@@ -229,26 +349,51 @@ namespace bdn::ui::yoga
             auto it = _views.find(parent.get());
             if (it != _views.end()) {
                 viewData->isIn = true;
+                updateChildOrder(*viewData, parent.get());
 
-                auto childList = parent->childViews();
+                auto &parentData = it->second;
+                parentData->childrenChanged(true);
 
-                YGNodeRemoveAllChildren(it->second->ygNode);
+                YGNodeInsertChild(parentData->ygNode, viewData->ygNode,
+                                  childPosition(parentData->ygNode, viewData->childOrder));
 
-                it->second->childrenChanged(true);
+                parentData->childrenChanged();
+            }
+        }
+    }
 
-                for (auto &child : parent->childViews()) {
-                    if (child->visible.get()) {
-                        auto itChild = _views.find(child.get());
-                        if (itChild != _views.end()) {
-                            YGNodeInsertChild(it->second->ygNode, itChild->second->ygNode,
-                                              YGNodeGetChildCount(it->second->ygNode));
-                        }
-                    }
-                }
+    void Layout::updateChildOrder(ViewData &viewData, View *parent)
+    {
+        if (parent != nullptr && viewData.childOrderParent != parent) {
+            viewData.childOrder = ++_lastChildOrder;
+            viewData.childOrderParent = parent;
+        }
+    }
 
-                it->second->childrenChanged();
+    uint32_t Layout::childPosition(YGNodeRef parentNode, uint64_t childOrder)
+    {
+        auto orderOf = [parentNode](uint32_t index) {
+            return static_cast<ViewData *>(YGNodeGetContext(YGNodeGetChild(parentNode, index)))->childOrder;
+        };
+
+        uint32_t count = YGNodeGetChildCount(parentNode);
+
+        // Appending is by far the most common case
+        if (count == 0 || orderOf(count - 1) < childOrder) {
+            return count;
+        }
+
+        uint32_t begin = 0;
+        uint32_t end = count;
+        while (begin < end) {
+            uint32_t middle = begin + (end - begin) / 2;
+            if (orderOf(middle) < childOrder) {
+                begin = middle + 1;
+            } else {
+                end = middle;
             }
         }
+        return begin;
     }
 
     void Layout::remove(View *view)
@@ -257,15 +402,12 @@ namespace bdn::ui::yoga
         if (it != _views.end()) {
             if (it->second->isIn) {
                 if (auto owner = YGNodeGetOwner(it->second->ygNode)) {
-
-                    auto parentData = std::find_if(_views.begin(), _views.end(), [&owner](auto &viewData) {
-                        return viewData.second->ygNode == owner;
-                    });
-
                     it->second->isIn = false;
                     YGNodeRemoveChild(owner, it->second->ygNode);
-                    if (parentData != _views.end()) {
-                        parentData->second->childrenChanged();
+
+                    // Every node in the layout has its ViewData as context
+                    if (auto parentData = static_cast<ViewData *>(YGNodeGetContext(owner))) {
+                        parentData->childrenChanged();
                     }
                 }
             }
@@ -1,9 +1,18 @@
+#include <bdn/property/PropertyTransaction.h>
 #include <bdn/ui/Window.h>
 #include <bdn/ui/yoga/ViewData.h>
 #include <yoga/YGNode.h>
 
+#include <atomic>
+
 namespace bdn::ui::yoga
 {
+    namespace
+    {
+        std::atomic<uint64_t> measureCacheHits{0};
+        std::atomic<uint64_t> measureCacheMisses{0};
+    }
+
     ViewData::ViewData(View *v) : view(v), isRootNode(false), isIn(false)
     {
         auto config = YGConfigGetDefault();
@@ -33,13 +42,32 @@ namespace bdn::ui::yoga
     void ViewData::doLayout()
     {
         if (isRootNode) {
-            YGNodeCalculateLayout(ygNode, geometry->width, geometry->height, YGDirectionLTR);
-            yogaVisit(ygNode, &applyLayout);
+            calculateLayout();
+
+            // Deliver the geometry changes once the whole tree is updated
+            PropertyTransaction transaction;
+            applyCalculatedLayout();
+            transaction.commit();
 
             ygNode->setDirty(false);
         }
     }
 
+    void ViewData::calculateLayout()
+    {
+        if (isRootNode) {
+            YGNodeCalculateLayout(ygNode, geometry->width, geometry->height, YGDirectionLTR);
+            hasLayout = true;
+        }
+    }
+
+    void ViewData::applyCalculatedLayout()
+    {
+        if (isRootNode) {
+            yogaVisit(ygNode, &applyLayout);
+        }
+    }
+
     void ViewData::onDirtied(YGNodeRef node)
     {
         auto *viewData = static_cast<ViewData *>(YGNodeGetContext(node));
@@ -51,14 +79,48 @@ namespace bdn::ui::yoga
     {
         auto viewData = static_cast<ViewData *>(YGNodeGetContext(node));
 
+        // An undefined dimension is not a constraint, its value does not matter
+        auto sameConstraint = [](float a, YGMeasureMode aMode, float b, YGMeasureMode bMode) {
+            return aMode == bMode && (aMode == YGMeasureModeUndefined || a == b);
+        };
+
+        for (const auto &entry : viewData->measureCache) {
+            if (entry.contentGeneration == viewData->contentGeneration &&
+                sameConstraint(entry.width, entry.widthMode, width, widthMode) &&
+                sameConstraint(entry.height, entry.heightMode, height, heightMode)) {
+                measureCacheHits++;
+                return entry.size;
+            }
+        }
+        measureCacheMisses++;
+
         node->getConfig()->pointScaleFactor = viewData->view->pointScaleFactor();
 
         Size constraintSize = Size(widthMode == YGMeasureModeUndefined ? Size::componentNone() : width,
                                    heightMode == YGMeasureModeUndefined ? Size::componentNone() : height);
 
         Size s = viewData->view->sizeForSpace(constraintSize);
+        YGSize size{.width = (float)s.width, .height = (float)s.height};
 
-        return (YGSize){.width = (float)s.width, .height = (float)s.height};
+        auto &entry = viewData->measureCache[viewData->nextMeasureCacheEntry];
+        entry = {width, widthMode, height, heightMode, viewData->contentGeneration, size};
+        viewData->nextMeasureCacheEntry = (viewData->nextMeasureCacheEntry + 1) % viewData->measureCache.size();
+
+        return size;
+    }
+
+    ViewData::MeasureCacheStatistics ViewData::measureCacheStatistics()
+    {
+        MeasureCacheStatistics statistics;
+        statistics.hits = measureCacheHits;
+        statistics.misses = measureCacheMisses;
+        return statistics;
+    }
+
+    void ViewData::resetMeasureCacheStatistics()
+    {
+        measureCacheHits = 0;
+        measureCacheMisses = 0;
     }
 
     float ViewData::baselineFunc(YGNodeRef node, float width, float height)
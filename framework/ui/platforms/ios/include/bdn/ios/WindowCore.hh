@@ -49,7 +49,7 @@ namespace bdn::ui::ios
 
         void frameChanged() override;
 
-        void updateFromStylesheet(json stylesheet) override;
+        void updateFromStylesheet(const json &stylesheet) override;
 
       private:
         void updateContent(const std::shared_ptr<View> &newContent);
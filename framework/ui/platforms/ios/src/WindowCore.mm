@@ -385,7 +385,7 @@ namespace bdn::ui::ios
         _contentView = newContent;
     }
 
-    void WindowCore::updateFromStylesheet(nlohmann::json stylesheet)
+    void WindowCore::updateFromStylesheet(const nlohmann::json &stylesheet)
     {
         if (stylesheet.count("status-bar-style")) {
             if (stylesheet.at("status-bar-style") == "light") {
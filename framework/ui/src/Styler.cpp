@@ -1,4 +1,5 @@
 #include <bdn/log.h>
+#include <bdn/property/PropertyTransaction.h>
 #include <bdn/ui/Styler.h>
 
 namespace bdn::ui
@@ -59,6 +60,8 @@ namespace bdn::ui
 
     void Styler::rematchAllViews(const std::string &matcherName)
     {
+        PropertyTransaction transaction;
+
         for (auto it = _data.begin(); it != _data.end();) {
             if (it->second.usedMatchers.find(matcherName) != it->second.usedMatchers.end()) {
                 if (auto view = it->first.lock()) {
@@ -71,5 +74,7 @@ namespace bdn::ui
 
             ++it;
         }
+
+        transaction.commit();
     }
 }
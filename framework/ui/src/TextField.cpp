@@ -44,11 +44,13 @@ namespace bdn::ui
     void TextField::updateFromStylesheet()
     {
         if (auto core = View::core<TextField::Core>()) {
-            if (stylesheet->count("font")) {
-                core->font = (Font)stylesheet->at("font");
-            } else {
-                core->font = Font();
-            }
+            stylesheet.read([&](const json &sheet) {
+                if (sheet.count("font")) {
+                    core->font = (Font)sheet.at("font");
+                } else {
+                    core->font = Font();
+                }
+            });
         }
 
         View::updateFromStylesheet();
@@ -92,13 +92,15 @@ namespace bdn::ui
     void View::updateFromStylesheet()
     {
         if (auto core = viewCore()) {
-            if (stylesheet->count("background-color")) {
-                core->backgroundColor = stylesheet->at("background-color");
-            } else {
-                core->backgroundColor = std::nullopt;
-            }
-
-            core->updateFromStylesheet(stylesheet.get());
+            stylesheet.read([&](const json &sheet) {
+                if (sheet.count("background-color")) {
+                    core->backgroundColor = sheet.at("background-color");
+                } else {
+                    core->backgroundColor = std::nullopt;
+                }
+
+                core->updateFromStylesheet(sheet);
+            });
         }
     }
 
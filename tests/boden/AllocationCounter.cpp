@@ -0,0 +1,32 @@
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local size_t t_allocations = 0;
+    thread_local size_t t_bytes = 0;
+}
+
+void *operator new(std::size_t size)
+{
+    t_allocations++;
+    t_bytes += size;
+
+    if (void *memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+
+namespace bdn
+{
+    AllocationCounter::AllocationCounter() : _start(t_allocations), _startBytes(t_bytes) {}
+
+    size_t AllocationCounter::allocations() const { return t_allocations - _start; }
+    size_t AllocationCounter::bytes() const { return t_bytes - _startBytes; }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+namespace bdn
+{
+    /** Counts the heap allocations made by the current thread while the
+        counter exists, and the number of bytes they requested.
+
+        The test executable replaces the global operator new for this, see
+        AllocationCounter.cpp.
+     */
+    class AllocationCounter
+    {
+      public:
+        AllocationCounter();
+
+        size_t allocations() const;
+        size_t bytes() const;
+
+      private:
+        size_t _start;
+        size_t _startBytes;
+    };
+}
@@ -0,0 +1,280 @@
+#include <atomic>
+#include <bdn/ConcurrentDispatchQueue.h>
+#include <bdn/DispatchQueue.h>
+#include <bdn/StopWatch.h>
+#include <bdn/log.h>
+#include <chrono>
+#include <condition_variable>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace bdn
+{
+    struct CompletionCounter
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        int count = 0;
+
+        void operator()()
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            count++;
+            cv.notify_all();
+        }
+
+        bool waitFor(int expected)
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            return cv.wait_for(lk, 1min, [&] { return count >= expected; });
+        }
+    };
+
+    TEST(ConcurrentDispatchQueue, Init)
+    {
+        ConcurrentDispatchQueue queue(4);
+        EXPECT_EQ(queue.numberOfWorkers(), 4u);
+    }
+
+    TEST(ConcurrentDispatchQueue, Async)
+    {
+        CompletionCounter counter;
+        ConcurrentDispatchQueue queue;
+
+        for (int i = 0; i < 1000; i++) {
+            queue.dispatchAsync(std::ref(counter));
+        }
+
+        EXPECT_TRUE(counter.waitFor(1000));
+    }
+
+    TEST(ConcurrentDispatchQueue, Sync)
+    {
+        int value = 0;
+        ConcurrentDispatchQueue queue;
+
+        queue.dispatchSync([&value]() { value = 42; });
+
+        EXPECT_EQ(value, 42);
+    }
+
+    TEST(ConcurrentDispatchQueue, SyncRecursive)
+    {
+        int calls = 0;
+        ConcurrentDispatchQueue queue(2);
+
+        queue.dispatchSync([&]() {
+            queue.dispatchSync([&]() { calls++; });
+            calls++;
+        });
+
+        EXPECT_EQ(calls, 2);
+    }
+
+    TEST(ConcurrentDispatchQueue, SyncPropagatesException)
+    {
+        ConcurrentDispatchQueue queue(2);
+
+        EXPECT_THROW(queue.dispatchSync([]() { throw std::runtime_error("Test"); }), std::runtime_error);
+
+        // The queue is still usable afterwards
+        int value = 0;
+        queue.dispatchSync([&]() { value = 1; });
+        EXPECT_EQ(value, 1);
+    }
+
+    TEST(ConcurrentDispatchQueue, SyncOnCancelledQueue)
+    {
+        ConcurrentDispatchQueue queue(2);
+        queue.cancel();
+
+        bool ran = false;
+        EXPECT_NO_THROW(queue.dispatchSync([&]() { ran = true; }));
+        EXPECT_FALSE(ran);
+    }
+
+    TEST(ConcurrentDispatchQueue, RunsInParallel)
+    {
+        ConcurrentDispatchQueue queue(4);
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        int arrived = 0;
+        CompletionCounter counter;
+
+        // Every function waits until all of them have started, which can only
+        // succeed if they are executed by different workers at the same time.
+        for (int i = 0; i < 4; i++) {
+            queue.dispatchAsync([&]() {
+                {
+                    std::unique_lock<std::mutex> lk(mutex);
+                    arrived++;
+                    cv.notify_all();
+                    cv.wait_for(lk, 10s, [&] { return arrived == 4; });
+                }
+                counter();
+            });
+        }
+
+        EXPECT_TRUE(counter.waitFor(4));
+        EXPECT_EQ(arrived, 4);
+    }
+
+    TEST(ConcurrentDispatchQueue, StealsNestedWork)
+    {
+        ConcurrentDispatchQueue queue(4);
+        CompletionCounter counter;
+
+        std::mutex mutex;
+        std::set<std::thread::id> threads;
+
+        // All work is dispatched from a single worker and ends up on its own
+        // deque. The other workers have to steal in order to help.
+        queue.dispatchAsync([&]() {
+            for (int i = 0; i < 400; i++) {
+                queue.dispatchAsync([&]() {
+                    std::this_thread::sleep_for(100us);
+                    {
+                        std::unique_lock<std::mutex> lk(mutex);
+                        threads.insert(std::this_thread::get_id());
+                    }
+                    counter();
+                });
+            }
+        });
+
+        EXPECT_TRUE(counter.waitFor(400));
+        EXPECT_GT(threads.size(), 1u);
+    }
+
+    TEST(ConcurrentDispatchQueue, Delayed)
+    {
+        CompletionCounter counter;
+        ConcurrentDispatchQueue queue;
+
+        auto t = ConcurrentDispatchQueue::Clock::now();
+
+        queue.dispatchAsyncDelayed(100ms, std::ref(counter));
+
+        EXPECT_TRUE(counter.waitFor(1));
+        EXPECT_GE(ConcurrentDispatchQueue::Clock::now(), t + 100ms);
+    }
+
+    TEST(ConcurrentDispatchQueue, Timer)
+    {
+        CompletionCounter counter;
+        std::atomic<int> calls(0);
+        ConcurrentDispatchQueue queue;
+
+        queue.createTimer(10ms, [&]() {
+            counter();
+            return ++calls != 10;
+        });
+
+        EXPECT_TRUE(counter.waitFor(10));
+    }
+
+    TEST(ConcurrentDispatchQueue, CancelReleasesSyncWaiters)
+    {
+        ConcurrentDispatchQueue queue(1);
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool release = false;
+
+        queue.dispatchAsync([&]() {
+            std::unique_lock<std::mutex> lk(mutex);
+            cv.wait(lk, [&] { return release; });
+        });
+
+        std::thread t([&]() { queue.dispatchSync([]() {}); });
+
+        std::this_thread::sleep_for(10ms);
+        queue.cancel();
+
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            release = true;
+            cv.notify_all();
+        }
+
+        t.join();
+    }
+
+    // Simulates a small piece of CPU bound work, like parsing a short JSON
+    // document or decoding an image tile.
+    static uint64_t simulatedWork(uint64_t seed)
+    {
+        uint64_t value = seed;
+        for (int i = 0; i < 2000; i++) {
+            value = value * 6364136223846793005ull + 1442695040888963407ull;
+        }
+        return value;
+    }
+
+    template <class Queue> double measureThroughput(Queue &queue, int numberOfProducers, int functionsPerProducer)
+    {
+        std::atomic<uint64_t> sink(0);
+        std::atomic<int> remaining(numberOfProducers * functionsPerProducer);
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done = false;
+
+        StopWatch watch;
+
+        std::vector<std::thread> producers;
+        for (int p = 0; p < numberOfProducers; p++) {
+            producers.emplace_back([&]() {
+                for (int i = 0; i < functionsPerProducer; i++) {
+                    queue.dispatchAsync([&, i]() {
+                        sink += simulatedWork(i);
+                        if (--remaining == 0) {
+                            std::unique_lock<std::mutex> lk(mutex);
+                            done = true;
+                            cv.notify_all();
+                        }
+                    });
+                }
+            });
+        }
+
+        for (auto &producer : producers) {
+            producer.join();
+        }
+
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            EXPECT_TRUE(cv.wait_for(lk, 1min, [&] { return done; }));
+        }
+
+        return (numberOfProducers * functionsPerProducer) / watch.elapsed().count();
+    }
+
+    TEST(ConcurrentDispatchQueue, DISABLED_ThroughputBenchmark)
+    {
+        const int functionsPerProducer = 5000;
+
+        for (int numberOfProducers : {1, 2, 4, 8}) {
+            double serialThroughput = 0;
+            double concurrentThroughput = 0;
+
+            {
+                DispatchQueue queue;
+                serialThroughput = measureThroughput(queue, numberOfProducers, functionsPerProducer);
+            }
+            {
+                ConcurrentDispatchQueue queue;
+                concurrentThroughput = measureThroughput(queue, numberOfProducers, functionsPerProducer);
+            }
+
+            logstream() << "Producers: " << numberOfProducers << ", DispatchQueue: " << (int)serialThroughput
+                        << " functions/s, ConcurrentDispatchQueue: " << (int)concurrentThroughput << " functions/s";
+        }
+    }
+}
@@ -0,0 +1,127 @@
+#include <bdn/platform.h>
+
+#ifdef BDN_ENABLE_COROUTINES
+
+#include "AllocationCounter.h"
+
+#include <bdn/ConcurrentDispatchQueue.h>
+#include <bdn/Coroutine.h>
+#include <bdn/DispatchQueue.h>
+#include <bdn/Future.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace bdn
+{
+    TEST(Coroutine, Schedule)
+    {
+        DispatchQueue queue;
+        std::thread::id queueThread;
+        queue.dispatchSync([&]() { queueThread = std::this_thread::get_id(); });
+
+        auto coroutine = [&]() -> Future<std::thread::id> {
+            co_await queue.schedule();
+            co_return std::this_thread::get_id();
+        };
+
+        EXPECT_EQ(coroutine().get(), queueThread);
+    }
+
+    TEST(Coroutine, ScheduleAfter)
+    {
+        DispatchQueue queue;
+
+        auto coroutine = [&]() -> Future<DispatchQueue::Clock::duration> {
+            auto start = DispatchQueue::Clock::now();
+            co_await queue.scheduleAfter(20ms);
+            co_return DispatchQueue::Clock::now() - start;
+        };
+
+        EXPECT_GE(coroutine().get(), 20ms);
+    }
+
+    TEST(Coroutine, AwaitFuture)
+    {
+        auto pool = std::make_shared<ConcurrentDispatchQueue>(2);
+        DispatchQueue mainQueue;
+        std::thread::id mainThread;
+        mainQueue.dispatchSync([&]() { mainThread = std::this_thread::get_id(); });
+
+        // Fetch on the pool, parse off-thread, continue on the "main" queue
+        auto pipeline = [&]() -> Future<int> {
+            auto text = co_await dispatchFuture(pool, []() { return std::string("41"); });
+            co_await pool->schedule();
+            int value = std::stoi(text);
+            co_await mainQueue.schedule();
+            EXPECT_EQ(std::this_thread::get_id(), mainThread);
+            co_return value + 1;
+        };
+
+        EXPECT_EQ(pipeline().get(), 42);
+    }
+
+    TEST(Coroutine, Exceptions)
+    {
+        DispatchQueue queue;
+
+        auto failing = [&]() -> Future<void> {
+            co_await queue.schedule();
+            throw std::runtime_error("Test");
+        };
+
+        auto catching = [&]() -> Future<bool> {
+            try {
+                co_await failing();
+            }
+            catch (const std::runtime_error &) {
+                co_return true;
+            }
+            co_return false;
+        };
+
+        EXPECT_TRUE(catching().get());
+    }
+
+    TEST(Coroutine, CancelledQueueDestroysCoroutine)
+    {
+        auto queue = std::make_unique<DispatchQueue>(true);
+
+        auto coroutine = [&]() -> Future<void> { co_await queue->schedule(); };
+        auto future = coroutine();
+
+        // The queue never runs, destroying it destroys the suspended coroutine
+        queue.reset();
+
+        EXPECT_THROW(future.get(), std::future_error);
+    }
+
+    TEST(Coroutine, FramesAreReused)
+    {
+        auto coroutine = [](int value) -> Future<int> { co_return value * 2; };
+
+        // Warm up the free list of this thread
+        coroutine(1).get();
+
+        size_t allocations;
+        Future<int> future;
+        {
+            AllocationCounter counter;
+            future = coroutine(2);
+            allocations = counter.allocations();
+        }
+
+        EXPECT_EQ(future.get(), 4);
+
+        // Only the shared state of the future is allocated, the frame comes
+        // from the free list
+        EXPECT_EQ(allocations, 1u);
+    }
+}
+
+#endif
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <array>
 #include <bdn/Application.h>
 #include <bdn/DispatchQueue.h>
@@ -6,6 +7,7 @@
 #include <future>
 #include <gtest/gtest.h>
 #include <memory>
+#include <numeric>
 #include <queue>
 #include <random>
 #include <thread>
@@ -84,6 +86,77 @@ namespace bdn
         EXPECT_TRUE(consumer.waitFor(2));
     }
 
+    TEST(DispatchQueue, SyncPropagatesException)
+    {
+        DispatchQueue queue(false);
+
+        EXPECT_THROW(queue.dispatchSync([]() { throw std::runtime_error("Test"); }), std::runtime_error);
+
+        // The queue is still usable afterwards
+        DispatchConsumer consumer;
+        queue.dispatchSync(std::ref(consumer));
+        EXPECT_EQ(consumer.triggers, 1);
+    }
+
+    TEST(DispatchQueue, CancelReleasesPendingSync)
+    {
+        DispatchQueue queue(false);
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool release = false;
+        bool ran = false;
+
+        queue.dispatchAsync([&]() {
+            std::unique_lock<std::mutex> lk(mutex);
+            cv.wait(lk, [&] { return release; });
+        });
+
+        std::thread t([&]() { queue.dispatchSync([&]() { ran = true; }); });
+
+        std::this_thread::sleep_for(10ms);
+        auto cancelTime = DispatchQueue::Clock::now();
+        queue.cancel();
+        t.join();
+
+        // The waiter has to be released right away, not after the blocking function returned
+        EXPECT_LT(DispatchQueue::Clock::now() - cancelTime, 1s);
+
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            release = true;
+            cv.notify_all();
+        }
+
+        EXPECT_FALSE(ran);
+    }
+
+    TEST(DispatchQueue, DISABLED_SyncLatencyBenchmark)
+    {
+        const int numberOfCalls = 10000;
+
+        DispatchQueue queue(false);
+        int value = 0;
+
+        std::vector<std::chrono::nanoseconds> roundTrips;
+        roundTrips.reserve(numberOfCalls);
+
+        for (int i = 0; i < numberOfCalls; i++) {
+            auto start = DispatchQueue::Clock::now();
+            queue.dispatchSync([&]() { value++; });
+            roundTrips.push_back(DispatchQueue::Clock::now() - start);
+        }
+
+        EXPECT_EQ(value, numberOfCalls);
+
+        std::sort(roundTrips.begin(), roundTrips.end());
+        auto total = std::accumulate(roundTrips.begin(), roundTrips.end(), std::chrono::nanoseconds(0));
+
+        logstream() << "dispatchSync round trip: mean " << (total.count() / numberOfCalls) << "ns, median "
+                    << roundTrips[numberOfCalls / 2].count() << "ns, 99th percentile "
+                    << roundTrips[numberOfCalls * 99 / 100].count() << "ns";
+    }
+
     TEST(DispatchQueue, AsyncRecursive)
     {
         DispatchConsumer consumer;
@@ -97,6 +170,271 @@ namespace bdn
         EXPECT_TRUE(consumer.waitFor(2));
     }
 
+    TEST(DispatchQueue, AsyncFromManyThreadsKeepsOrderPerProducer)
+    {
+        const int numberOfProducers = 8;
+        const int functionsPerProducer = 10000;
+
+        DispatchConsumer consumer;
+        DispatchQueue queue(false);
+
+        // Only ever touched by the queue's thread
+        std::array<int, numberOfProducers> lastSeen;
+        lastSeen.fill(-1);
+        bool inOrder = true;
+
+        std::vector<std::thread> producers;
+        for (int p = 0; p < numberOfProducers; p++) {
+            producers.emplace_back([&, p]() {
+                for (int i = 0; i < functionsPerProducer; i++) {
+                    queue.dispatchAsync([&, p, i]() {
+                        if (lastSeen[p] != i - 1) {
+                            inOrder = false;
+                        }
+                        lastSeen[p] = i;
+                        if (i == functionsPerProducer - 1) {
+                            consumer();
+                        }
+                    });
+                }
+            });
+        }
+
+        for (auto &producer : producers) {
+            producer.join();
+        }
+
+        EXPECT_TRUE(consumer.waitFor(numberOfProducers));
+
+        queue.dispatchSync([&]() {
+            EXPECT_TRUE(inOrder);
+            for (int last : lastSeen) {
+                EXPECT_EQ(last, functionsPerProducer - 1);
+            }
+        });
+    }
+
+    TEST(DispatchQueue, AsyncFromManyThreadsLosesNoWakeUp)
+    {
+        const int numberOfProducers = 3;
+        const int numberOfRounds = 2000;
+
+        DispatchConsumer consumer;
+        DispatchQueue queue(false);
+
+        // In every round each producer pushes one function at the same time
+        // as the queue's thread empties the queue. All of them have to run
+        // without a later dispatch waking the queue up.
+        std::atomic<int> round(0);
+        std::vector<std::thread> producers;
+        for (int p = 0; p < numberOfProducers; p++) {
+            producers.emplace_back([&]() {
+                for (int r = 1; r <= numberOfRounds; r++) {
+                    while (round < r) {
+                        std::this_thread::yield();
+                    }
+                    queue.dispatchAsync([&]() { consumer(); });
+                }
+            });
+        }
+
+        bool lostWakeUp = false;
+        for (int r = 1; r <= numberOfRounds && !lostWakeUp; r++) {
+            round = r;
+            lostWakeUp = !consumer.waitFor(r * numberOfProducers);
+        }
+        EXPECT_FALSE(lostWakeUp);
+
+        round = numberOfRounds;
+        for (auto &producer : producers) {
+            producer.join();
+        }
+    }
+
+    TEST(DispatchQueue, DISABLED_SubmissionBenchmark)
+    {
+        const int functionsPerProducer = 20000;
+
+        for (int numberOfProducers : {1, 2, 4, 8}) {
+            DispatchConsumer consumer;
+            DispatchQueue queue(false);
+            std::atomic<int> remaining(numberOfProducers * functionsPerProducer);
+
+            auto start = DispatchQueue::Clock::now();
+
+            std::vector<std::thread> producers;
+            for (int p = 0; p < numberOfProducers; p++) {
+                producers.emplace_back([&]() {
+                    for (int i = 0; i < functionsPerProducer; i++) {
+                        queue.dispatchAsync([&]() {
+                            if (--remaining == 0) {
+                                consumer();
+                            }
+                        });
+                    }
+                });
+            }
+
+            for (auto &producer : producers) {
+                producer.join();
+            }
+            auto submitted = DispatchQueue::Clock::now();
+
+            EXPECT_TRUE(consumer.waitFor(1));
+            auto executed = DispatchQueue::Clock::now();
+
+            std::chrono::duration<double> submitTime = submitted - start;
+            std::chrono::duration<double> totalTime = executed - start;
+
+            logstream() << "Producers: " << numberOfProducers << ", submitted "
+                        << (int)(numberOfProducers * functionsPerProducer / submitTime.count()) << " functions/s"
+                        << ", executed " << (int)(numberOfProducers * functionsPerProducer / totalTime.count())
+                        << " functions/s";
+        }
+    }
+
+    // Keeps the queue's thread busy until release() is called, so that work can
+    // pile up in the lanes.
+    struct QueueBlocker
+    {
+        QueueBlocker(DispatchQueue &queue)
+        {
+            auto released = _release.get_future().share();
+            queue.dispatchAsync(DispatchQueue::Priority::UserInteractive, [released]() { released.wait(); });
+        }
+
+        void release() { _release.set_value(); }
+
+      private:
+        std::promise<void> _release;
+    };
+
+    TEST(DispatchQueue, PriorityOrder)
+    {
+        using Priority = DispatchQueue::Priority;
+
+        DispatchQueue queue(false);
+        QueueBlocker blocker(queue);
+
+        std::vector<Priority> order;
+        for (auto priority : {Priority::Background, Priority::Utility, Priority::Default, Priority::UserInteractive}) {
+            queue.dispatchAsync(priority, [&order, priority]() { order.push_back(priority); });
+        }
+
+        blocker.release();
+        queue.dispatchSync(Priority::Background, []() {});
+
+        EXPECT_EQ(order, (std::vector<Priority>{Priority::UserInteractive, Priority::Default, Priority::Utility,
+                                                Priority::Background}));
+    }
+
+    TEST(DispatchQueue, StarvationProtection)
+    {
+        using Priority = DispatchQueue::Priority;
+
+        DispatchQueue queue(false);
+        queue.setStarvationLimit(Priority::Background, 10ms);
+
+        QueueBlocker blocker(queue);
+
+        int position = 0;
+        int backgroundPosition = -1;
+
+        queue.dispatchAsync(Priority::Background, [&]() { backgroundPosition = position++; });
+        for (int i = 0; i < 100; i++) {
+            queue.dispatchAsync(Priority::UserInteractive, [&]() { position++; });
+        }
+
+        std::this_thread::sleep_for(20ms);
+        blocker.release();
+        queue.dispatchSync(Priority::Background, []() {});
+
+        // The background function has waited longer than its limit and
+        // therefore runs ahead of the user interactive ones
+        EXPECT_EQ(backgroundPosition, 0);
+    }
+
+    TEST(DispatchQueue, Deadline)
+    {
+        using Priority = DispatchQueue::Priority;
+
+        DispatchQueue queue(false);
+        QueueBlocker blocker(queue);
+
+        std::vector<int> order;
+
+        for (int i = 0; i < 10; i++) {
+            queue.dispatchAsync(Priority::UserInteractive, [&order]() { order.push_back(0); });
+        }
+        queue.dispatchAsync(Priority::Background, DispatchQueue::Clock::now() + 5ms,
+                            [&order]() { order.push_back(2); });
+        queue.dispatchAsync(Priority::Background, DispatchQueue::Clock::now() + 1ms,
+                            [&order]() { order.push_back(1); });
+
+        std::this_thread::sleep_for(20ms);
+        blocker.release();
+        queue.dispatchSync(Priority::Background, []() {});
+
+        ASSERT_EQ(order.size(), 12u);
+        EXPECT_EQ(order[0], 1);
+        EXPECT_EQ(order[1], 2);
+
+        auto statistics = queue.statistics(Priority::Background);
+        EXPECT_EQ(statistics.overdue, 2u);
+    }
+
+    TEST(DispatchQueue, DeadlinesKeepTheirPriority)
+    {
+        using Priority = DispatchQueue::Priority;
+
+        DispatchQueue queue(false);
+        QueueBlocker blocker(queue);
+
+        std::vector<int> order;
+        auto now = DispatchQueue::Clock::now();
+
+        for (int i = 0; i < 5; i++) {
+            queue.dispatchAsync(Priority::Default, [&order]() { order.push_back(1); });
+        }
+        // Neither deadline passes during the test. The user interactive
+        // function must not wait for the background one, whose deadline is
+        // earlier.
+        queue.dispatchAsync(Priority::Background, now + 1h, [&order]() { order.push_back(2); });
+        queue.dispatchAsync(Priority::UserInteractive, now + 2h, [&order]() { order.push_back(0); });
+
+        blocker.release();
+        queue.dispatchSync(Priority::Background, []() {});
+
+        EXPECT_EQ(order, (std::vector<int>{0, 1, 1, 1, 1, 1, 2}));
+    }
+
+    TEST(DispatchQueue, LaneStatistics)
+    {
+        using Priority = DispatchQueue::Priority;
+
+        DispatchQueue queue(false);
+        QueueBlocker blocker(queue);
+
+        for (int i = 0; i < 5; i++) {
+            queue.dispatchAsync(Priority::Utility, []() {});
+        }
+
+        EXPECT_EQ(queue.statistics(Priority::Utility).depth, 5u);
+
+        std::this_thread::sleep_for(10ms);
+        blocker.release();
+        queue.dispatchSync(Priority::Background, []() {});
+
+        auto statistics = queue.statistics(Priority::Utility);
+        EXPECT_EQ(statistics.depth, 0u);
+        EXPECT_EQ(statistics.executed, 5u);
+        EXPECT_GE(statistics.maxWait, 10ms);
+        EXPECT_GE(statistics.averageWait(), 10ms);
+
+        queue.resetStatistics();
+        EXPECT_EQ(queue.statistics(Priority::Utility).executed, 0u);
+    }
+
     TEST(DispatchQueue, Delayed)
     {
         DispatchConsumer consumer;
@@ -126,6 +464,89 @@ namespace bdn
         EXPECT_GE(DispatchQueue::Clock::now(), t + 100ms);
     }
 
+    TEST(DispatchQueue, DelayedOrder)
+    {
+        DispatchQueue queue(false);
+
+        std::vector<int> order;
+        DispatchConsumer consumer;
+
+        for (int delay : {50, 10, 30, 20, 40, 10}) {
+            queue.dispatchAsyncDelayed(1ms * delay, [&, delay]() {
+                order.push_back(delay);
+                consumer();
+            });
+        }
+
+        EXPECT_TRUE(consumer.waitFor(6));
+        queue.dispatchSync([&]() { EXPECT_EQ(order, (std::vector<int>{10, 10, 20, 30, 40, 50})); });
+    }
+
+    TEST(DispatchQueue, CancelDelayed)
+    {
+        DispatchQueue queue(false);
+
+        bool cancelledRan = false;
+        DispatchConsumer consumer;
+
+        auto handle = queue.dispatchAsyncDelayed(20ms, [&]() { cancelledRan = true; });
+        queue.dispatchAsyncDelayed(50ms, std::ref(consumer));
+
+        EXPECT_TRUE(handle.isValid());
+        handle.cancel();
+        EXPECT_FALSE(handle.isValid());
+
+        EXPECT_TRUE(consumer.waitFor(1));
+        queue.dispatchSync([&]() { EXPECT_FALSE(cancelledRan); });
+    }
+
+    TEST(DispatchQueue, CancelTimer)
+    {
+        DispatchQueue queue(false);
+
+        std::atomic<int> calls(0);
+        DispatchConsumer consumer;
+
+        auto handle = queue.createTimer(5ms, [&]() {
+            if (++calls == 3) {
+                consumer();
+            }
+            return true;
+        });
+
+        EXPECT_TRUE(consumer.waitFor(1));
+        handle.cancel();
+
+        // Nothing can be running anymore once a sync call went through
+        queue.dispatchSync([]() {});
+        int callsAfterCancel = calls;
+
+        std::this_thread::sleep_for(50ms);
+        EXPECT_EQ(calls, callsAfterCancel);
+    }
+
+    TEST(DispatchQueue, CancelTimerFromWithin)
+    {
+        DispatchQueue queue(false);
+
+        std::atomic<int> calls(0);
+        DispatchConsumer consumer;
+        DispatchQueue::TimerHandle handle;
+
+        queue.dispatchSync([&]() {
+            handle = queue.createTimer(5ms, [&]() {
+                calls++;
+                handle.cancel();
+                consumer();
+                return true;
+            });
+        });
+
+        EXPECT_TRUE(consumer.waitFor(1));
+        std::this_thread::sleep_for(50ms);
+        EXPECT_EQ(calls, 1);
+    }
+
     TEST(DispatchQueue, Slave)
     {
         DispatchQueue queue(true);
@@ -139,6 +560,220 @@ namespace bdn
         t.join();
     }
 
+    TEST(DispatchQueue, FrameEndCoalescing)
+    {
+        DispatchQueue queue(false);
+
+        int layoutKey = 0;
+        std::vector<int> calls;
+        std::promise<void> done;
+
+        queue.dispatchSync([&]() {
+            queue.dispatchAtFrameEnd(&layoutKey, [&]() { calls.push_back(1); });
+            queue.dispatchAtFrameEnd(nullptr, [&]() { calls.push_back(2); });
+            queue.dispatchAtFrameEnd(&layoutKey, [&]() { calls.push_back(3); });
+            queue.dispatchAtFrameEnd(nullptr, [&]() { calls.push_back(4); });
+            queue.dispatchAtFrameEnd(nullptr, [&]() { done.set_value(); });
+        });
+
+        done.get_future().wait();
+
+        EXPECT_EQ(calls, (std::vector<int>{3, 2, 4}));
+    }
+
+    TEST(DispatchQueue, FrameLoopInterleavesBurstWithTimers)
+    {
+        const int numberOfFunctions = 2000;
+
+        DispatchQueue queue(true);
+
+        int layoutKey = 0;
+        int executed = 0;
+        int executedWhenTimerFired = -1;
+        int layoutPasses = 0;
+
+        for (int i = 0; i < numberOfFunctions; i++) {
+            queue.dispatchAsync([&]() {
+                auto end = DispatchQueue::Clock::now() + 50us;
+                while (DispatchQueue::Clock::now() < end) {
+                }
+
+                executed++;
+                queue.dispatchAtFrameEnd(&layoutKey, [&]() { layoutPasses++; });
+
+                if (executed == numberOfFunctions) {
+                    queue.cancel();
+                }
+            });
+        }
+        queue.dispatchAsyncDelayed(5ms, [&]() { executedWhenTimerFired = executed; });
+
+        DispatchQueue::FrameBudget frameBudget;
+        frameBudget.interval = 8ms;
+        frameBudget.budget = 4ms;
+        queue.enterFrameLoop(frameBudget);
+
+        EXPECT_EQ(executed, numberOfFunctions);
+
+        // The timer did not have to wait for the whole burst
+        EXPECT_GE(executedWhenTimerFired, 0);
+        EXPECT_LT(executedWhenTimerFired, numberOfFunctions / 2);
+
+        auto statistics = queue.frameStatistics();
+        EXPECT_GT(statistics.frames, 1u);
+
+        // One layout pass per frame instead of one per function
+        EXPECT_GT(layoutPasses, 0);
+        EXPECT_LE(static_cast<size_t>(layoutPasses), statistics.frames);
+
+        logstream() << "Frame loop: " << statistics.frames << " frames, " << statistics.cutShort << " cut short, "
+                    << statistics.overruns << " overruns, average frame "
+                    << std::chrono::duration_cast<std::chrono::microseconds>(statistics.averageFrame()).count()
+                    << "us, max frame "
+                    << std::chrono::duration_cast<std::chrono::microseconds>(statistics.maxFrame).count() << "us";
+    }
+
+    TEST(DispatchQueue, FrameLoopCountsOnlySlowFramesAsOverruns)
+    {
+        const int numberOfFunctions = 1000;
+
+        DispatchQueue queue(true);
+
+        auto busy = [](DispatchQueue::Clock::duration duration) {
+            auto end = DispatchQueue::Clock::now() + duration;
+            while (DispatchQueue::Clock::now() < end) {
+            }
+        };
+
+        for (int i = 0; i < numberOfFunctions; i++) {
+            queue.dispatchAsync([&]() { busy(50us); });
+        }
+        queue.dispatchAsync([&]() { busy(60ms); });
+        queue.dispatchAsync([&]() { queue.cancel(); });
+
+        DispatchQueue::FrameBudget frameBudget;
+        frameBudget.interval = 8ms;
+        frameBudget.budget = 4ms;
+        frameBudget.overrunTolerance = 10ms;
+        queue.enterFrameLoop(frameBudget);
+
+        auto statistics = queue.frameStatistics();
+
+        // Frames full of small functions end just past the budget, only the
+        // one running the slow function is an overrun
+        EXPECT_GT(statistics.cutShort, 1u);
+        EXPECT_EQ(statistics.overruns, 1u);
+        EXPECT_GE(statistics.totalOverrun, 56ms);
+    }
+
+    TEST(DispatchQueue, Coalesced)
+    {
+        DispatchQueue queue(false);
+        QueueBlocker blocker(queue);
+
+        int key = 0;
+        int calls = 0;
+        int lastValue = -1;
+
+        for (int i = 0; i < 1000; i++) {
+            queue.dispatchAsyncCoalesced(&key, [&calls, &lastValue, i]() {
+                calls++;
+                lastValue = i;
+            });
+        }
+
+        // Only a single function was queued
+        EXPECT_EQ(queue.statistics(DispatchQueue::Priority::Default).depth, 1u);
+
+        blocker.release();
+        queue.dispatchSync([]() {});
+
+        EXPECT_EQ(calls, 1);
+        EXPECT_EQ(lastValue, 999);
+
+        // Once it ran, the key can be used again
+        queue.dispatchAsyncCoalesced(&key, [&calls]() { calls++; });
+        queue.dispatchSync([]() {});
+        EXPECT_EQ(calls, 2);
+    }
+
+    TEST(DispatchQueue, Debounced)
+    {
+        DispatchQueue queue(false);
+
+        int key = 0;
+        std::vector<int> values;
+        std::promise<void> lastCalled;
+        DispatchQueue::TimePoint lastDispatch;
+        DispatchQueue::TimePoint executed;
+
+        // Only the order is checked, a slow machine may well run more than one
+        // of the functions
+        for (int i = 0; i < 5; i++) {
+            lastDispatch = DispatchQueue::Clock::now();
+            queue.dispatchAsyncDebounced(&key, 50ms, [&, i]() {
+                values.push_back(i);
+                executed = DispatchQueue::Clock::now();
+                if (i == 4) {
+                    lastCalled.set_value();
+                }
+            });
+        }
+
+        ASSERT_EQ(lastCalled.get_future().wait_for(1min), std::future_status::ready);
+        queue.dispatchSync([]() {});
+
+        ASSERT_FALSE(values.empty());
+        EXPECT_TRUE(std::is_sorted(values.begin(), values.end()));
+        EXPECT_EQ(values.back(), 4);
+        EXPECT_GE(executed - lastDispatch, 50ms);
+    }
+
+    TEST(DispatchQueue, Throttled)
+    {
+        DispatchQueue queue(false);
+
+        int key = 0;
+        std::vector<int> values;
+        std::promise<void> lastCalled;
+
+        for (int i = 0; i < 20; i++) {
+            queue.dispatchAsyncThrottled(&key, 30ms, [&values, &lastCalled, i]() {
+                values.push_back(i);
+                if (i == 19) {
+                    lastCalled.set_value();
+                }
+            });
+            std::this_thread::sleep_for(5ms);
+        }
+
+        ASSERT_EQ(lastCalled.get_future().wait_for(1min), std::future_status::ready);
+        queue.dispatchSync([]() {});
+
+        // The first function runs right away and the last one is never lost.
+        // How many run in between depends on the machine's timing.
+        ASSERT_FALSE(values.empty());
+        EXPECT_EQ(values.front(), 0);
+        EXPECT_TRUE(std::is_sorted(values.begin(), values.end()));
+        EXPECT_EQ(values.back(), 19);
+    }
+
+    TEST(DispatchQueue, CancelCoalesced)
+    {
+        DispatchQueue queue(false);
+
+        int key = 0;
+        bool called = false;
+
+        queue.dispatchAsyncDebounced(&key, 10ms, [&called]() { called = true; });
+        queue.cancelCoalesced(&key);
+
+        std::this_thread::sleep_for(30ms);
+        queue.dispatchSync([]() {});
+
+        EXPECT_FALSE(called);
+    }
+
     TEST(DispatchQueue, AbortSyncDispatchWaitOnDestruct)
     {
         DispatchQueue queue(true);
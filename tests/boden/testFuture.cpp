@@ -0,0 +1,197 @@
+#include <bdn/ConcurrentDispatchQueue.h>
+#include <bdn/DispatchQueue.h>
+#include <bdn/Future.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace bdn
+{
+    TEST(Future, PromiseSetValue)
+    {
+        Promise<int> promise;
+        auto future = promise.future();
+        EXPECT_TRUE(future.valid());
+        EXPECT_FALSE(future.isReady());
+
+        promise.setValue(42);
+        EXPECT_TRUE(future.isReady());
+        EXPECT_EQ(future.get(), 42);
+        EXPECT_FALSE(future.valid());
+    }
+
+    TEST(Future, PromiseSetException)
+    {
+        Promise<int> promise;
+        auto future = promise.future();
+
+        promise.setException(std::make_exception_ptr(std::runtime_error("Test")));
+        EXPECT_THROW(future.get(), std::runtime_error);
+    }
+
+    TEST(Future, BrokenPromise)
+    {
+        Future<void> future;
+        {
+            Promise<void> promise;
+            future = promise.future();
+        }
+        EXPECT_THROW(future.get(), std::future_error);
+    }
+
+    TEST(Future, ThenRunsOnQueue)
+    {
+        auto queue = std::make_shared<DispatchQueue>();
+        std::thread::id queueThread;
+        queue->dispatchSync([&]() { queueThread = std::this_thread::get_id(); });
+
+        Promise<int> promise;
+        std::thread::id continuationThread;
+
+        auto result = promise.future().then(queue, [&](int value) {
+            continuationThread = std::this_thread::get_id();
+            return std::to_string(value * 2);
+        });
+
+        promise.setValue(21);
+
+        EXPECT_EQ(result.get(), "42");
+        EXPECT_EQ(continuationThread, queueThread);
+    }
+
+    TEST(Future, ChainAcrossQueues)
+    {
+        auto pool = std::make_shared<ConcurrentDispatchQueue>(2);
+        auto queue = std::make_shared<DispatchQueue>();
+
+        auto result = dispatchFuture(pool, []() { return 20; })
+                          .then(queue, [](int value) { return value + 1; })
+                          .then(pool, [](int value) { return value * 2; })
+                          .then(queue, [](int value) { EXPECT_EQ(value, 42); });
+
+        EXPECT_NO_THROW(result.get());
+    }
+
+    TEST(Future, ThenUnwrapsFutures)
+    {
+        auto queue = std::make_shared<DispatchQueue>();
+
+        Promise<int> inner;
+        auto innerFuture = std::make_shared<Future<int>>(inner.future());
+
+        auto result = makeReadyFuture().then(queue, [innerFuture]() { return std::move(*innerFuture); });
+
+        std::this_thread::sleep_for(10ms);
+        EXPECT_FALSE(result.isReady());
+
+        inner.setValue(7);
+        EXPECT_EQ(result.get(), 7);
+    }
+
+    TEST(Future, ThenPropagatesExceptions)
+    {
+        auto queue = std::make_shared<DispatchQueue>();
+
+        bool called = false;
+        auto result = dispatchFuture(queue, []() -> int { throw std::runtime_error("Test"); }).then(queue, [&](int) {
+            called = true;
+            return 0;
+        });
+
+        EXPECT_THROW(result.get(), std::runtime_error);
+        EXPECT_FALSE(called);
+    }
+
+    TEST(Future, Cancellation)
+    {
+        auto queue = std::make_shared<DispatchQueue>();
+
+        CancellationSource source;
+        bool cancelCallbackCalled = false;
+        source.token().onCancel([&]() { cancelCallbackCalled = true; });
+
+        Promise<void> promise;
+        bool called = false;
+        auto result = promise.future().then(queue, [&]() { called = true; }, source.token());
+
+        source.cancel();
+        EXPECT_TRUE(cancelCallbackCalled);
+
+        promise.setValue();
+
+        EXPECT_THROW(result.get(), CancelledException);
+        EXPECT_FALSE(called);
+    }
+
+    TEST(Future, WhenAll)
+    {
+        auto pool = std::make_shared<ConcurrentDispatchQueue>(4);
+
+        std::vector<Future<int>> futures;
+        for (int i = 0; i < 100; i++) {
+            futures.push_back(dispatchFuture(pool, [i]() { return i * i; }));
+        }
+
+        auto values = whenAll(std::move(futures)).get();
+        ASSERT_EQ(values.size(), 100u);
+        for (int i = 0; i < 100; i++) {
+            EXPECT_EQ(values[i], i * i);
+        }
+
+        EXPECT_TRUE(whenAll(std::vector<Future<int>>()).get().empty());
+    }
+
+    TEST(Future, WhenAllVoidFailsOnFirstError)
+    {
+        Promise<void> succeeding;
+        Promise<void> failing;
+
+        std::vector<Future<void>> futures;
+        futures.push_back(succeeding.future());
+        futures.push_back(failing.future());
+
+        auto all = whenAll(std::move(futures));
+
+        failing.setException(std::make_exception_ptr(std::runtime_error("Test")));
+        EXPECT_TRUE(all.isReady());
+        EXPECT_THROW(all.get(), std::runtime_error);
+
+        succeeding.setValue();
+    }
+
+    TEST(Future, WhenAny)
+    {
+        Promise<std::string> slow;
+        Promise<std::string> fast;
+
+        std::vector<Future<std::string>> futures;
+        futures.push_back(slow.future());
+        futures.push_back(fast.future());
+
+        auto any = whenAny(std::move(futures));
+
+        fast.setValue("fast");
+        slow.setValue("slow");
+
+        auto [index, value] = any.get();
+        EXPECT_EQ(index, 1u);
+        EXPECT_EQ(value, "fast");
+
+        Promise<void> first;
+        Promise<void> second;
+        std::vector<Future<void>> voidFutures;
+        voidFutures.push_back(first.future());
+        voidFutures.push_back(second.future());
+
+        auto anyVoid = whenAny(std::move(voidFutures));
+        first.setValue();
+        EXPECT_EQ(anyVoid.get(), 0u);
+    }
+}
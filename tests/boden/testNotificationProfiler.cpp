@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <bdn/Json.h>
+#include <bdn/NotificationProfiler.h>
+#include <bdn/Notifier.h>
+#include <bdn/property/Property.h>
+
+#include <algorithm>
+
+namespace bdn
+{
+    class NotificationProfilerTest : public testing::Test
+    {
+      protected:
+        void SetUp() override
+        {
+            NotificationProfiler::reset();
+            NotificationProfiler::setEnabled(true);
+        }
+
+        void TearDown() override
+        {
+            NotificationProfiler::setEnabled(false);
+            NotificationProfiler::reset();
+        }
+
+        static NotificationProfiler::Entry entry(const std::string &name)
+        {
+            auto entries = NotificationProfiler::entries();
+            auto it = std::find_if(entries.begin(), entries.end(), [&](auto &e) { return e.name == name; });
+            return it != entries.end() ? *it : NotificationProfiler::Entry{};
+        }
+    };
+
+    TEST_F(NotificationProfilerTest, DisabledRecordsNothing)
+    {
+        NotificationProfiler::setEnabled(false);
+
+        Notifier<int> notifier;
+        notifier += [](int) {};
+        notifier.notify(1);
+
+        Property<int> property(1);
+        property = 2;
+
+        EXPECT_TRUE(NotificationProfiler::entries().empty());
+    }
+
+    TEST_F(NotificationProfilerTest, CountsNotificationsAndFanOut)
+    {
+        Notifier<int> notifier;
+        NotificationProfiler::setName(notifier, "notifier");
+
+        int calls = 0;
+        for (int i = 0; i < 3; i++) {
+            notifier += [&calls](int) { calls++; };
+        }
+        notifier.notify(1);
+        auto subscription = notifier.subscribe([&calls](int) { calls++; });
+        notifier.unsubscribe(subscription);
+        notifier.notify(2);
+
+        auto stats = entry("notifier");
+        EXPECT_EQ(stats.notifications, 2u);
+        EXPECT_EQ(stats.subscriberCalls, 6u);
+        EXPECT_EQ(stats.maxSubscribers, 3u);
+        EXPECT_EQ(calls, 6);
+    }
+
+    TEST_F(NotificationProfilerTest, RecordsRedundantSets)
+    {
+        Property<int> plain(1);
+        NotificationProfiler::setName(plain.onChange(), "plain");
+        plain = 1;
+        plain = 2;
+        plain = 2;
+
+        auto plainStats = entry("plain");
+        EXPECT_EQ(plainStats.type, "int");
+        EXPECT_EQ(plainStats.sets, 3u);
+        EXPECT_EQ(plainStats.redundantSets, 2u);
+        EXPECT_EQ(plainStats.notifications, 0u);
+
+        Property<std::string> backed;
+        auto backing = backed.backing();
+        NotificationProfiler::setName(backing->onChange(), "backed");
+        backing->onChange() += [](auto) {};
+        backed = "a";
+        backed = "a";
+
+        auto backedStats = entry("backed");
+        EXPECT_EQ(backedStats.sets, 2u);
+        EXPECT_EQ(backedStats.redundantSets, 1u);
+        EXPECT_EQ(backedStats.notifications, 1u);
+        EXPECT_EQ(backedStats.subscriberCalls, 1u);
+    }
+
+    TEST_F(NotificationProfilerTest, ExportsJsonAndReport)
+    {
+        Property<int> property(0);
+        NotificationProfiler::setName(property.onChange(), "counter");
+        property.onChange() += [](auto &) {};
+        for (int i = 1; i <= 10; i++) {
+            property = i;
+        }
+
+        auto exported = json::parse(NotificationProfiler::toJson());
+        ASSERT_TRUE(exported.is_array());
+        auto it = std::find_if(exported.begin(), exported.end(), [](const json &e) { return e["name"] == "counter"; });
+        ASSERT_NE(it, exported.end());
+        EXPECT_EQ((*it)["notifications"], 10);
+        EXPECT_EQ((*it)["sets"], 10);
+        EXPECT_EQ((*it)["redundantSets"], 0);
+        EXPECT_TRUE(it->contains("callbackTimeNs"));
+
+        auto report = NotificationProfiler::report(5);
+        EXPECT_NE(report.find("counter"), std::string::npos);
+    }
+}
@@ -1,7 +1,12 @@
 #include <gtest/gtest.h>
 
+#include "AllocationCounter.h"
+
 #include <bdn/Notifier.h>
+#include <bdn/StopWatch.h>
+#include <bdn/log.h>
 #include <string>
+#include <vector>
 
 using namespace std::string_literals;
 
@@ -143,4 +148,203 @@ namespace bdn
         EXPECT_EQ(cc1.callCount, 2);
         EXPECT_EQ(cc2.callCount, 1);
     }
+
+    TEST(Notifier, SubscribeDuringNotify)
+    {
+        Notifier<> notifier;
+        int calls = 0;
+
+        notifier.subscribe([&]() {
+            // Forces the storage to grow while the first subscriber runs
+            for (int i = 0; i < 100; i++) {
+                notifier.subscribe([&calls]() { calls++; });
+            }
+        });
+
+        notifier.notify();
+        EXPECT_EQ(calls, 100);
+    }
+
+    TEST(Notifier, KeepsOrderAfterUnsubscribing)
+    {
+        Notifier<> notifier;
+        std::vector<int> order;
+        std::vector<Notifier<>::Subscription> subscriptions;
+
+        for (int i = 0; i < 10; i++) {
+            subscriptions.push_back(notifier.subscribe([&order, i]() { order.push_back(i); }));
+        }
+        for (int i = 0; i < 10; i += 2) {
+            notifier.unsubscribe(subscriptions[i]);
+        }
+        notifier.subscribe([&order]() { order.push_back(10); });
+
+        notifier.notify();
+        EXPECT_EQ(order, (std::vector<int>{1, 3, 5, 7, 9, 10}));
+
+        notifier.unsubscribe(subscriptions[3]);
+        order.clear();
+        notifier.notify();
+        EXPECT_EQ(order, (std::vector<int>{1, 5, 7, 9, 10}));
+    }
+
+    TEST(Notifier, ConnectionDisconnectsOnDestruction)
+    {
+        Notifier<> notifier;
+        int calls = 0;
+
+        {
+            auto connection = notifier.connect([&calls]() { calls++; });
+            EXPECT_TRUE(connection.isConnected());
+            notifier.notify();
+        }
+        notifier.notify();
+        EXPECT_EQ(calls, 1);
+
+        auto connection = notifier.connect([&calls]() { calls++; });
+        connection.disconnect();
+        EXPECT_FALSE(connection.isConnected());
+        notifier.notify();
+        EXPECT_EQ(calls, 1);
+    }
+
+    TEST(Notifier, ConnectionOutlivesNotifier)
+    {
+        NotifierConnection connection;
+        {
+            Notifier<> notifier;
+            connection = notifier.connect([]() {});
+            EXPECT_TRUE(connection.isConnected());
+        }
+        EXPECT_FALSE(connection.isConnected());
+        connection.disconnect();
+    }
+
+    TEST(Notifier, ConnectionCanBeMoved)
+    {
+        Notifier<> notifier;
+        int calls = 0;
+
+        std::vector<NotifierConnection> connections;
+        for (int i = 0; i < 10; i++) {
+            // Reallocating the vector moves the connections
+            connections.push_back(notifier.connect([&calls]() { calls++; }));
+        }
+        notifier.notify();
+        EXPECT_EQ(calls, 10);
+
+        connections.erase(connections.begin() + 2, connections.begin() + 5);
+        notifier.notify();
+        EXPECT_EQ(calls, 17);
+
+        connections.clear();
+        notifier.notify();
+        EXPECT_EQ(calls, 17);
+    }
+
+    TEST(Notifier, DisconnectDuringNotify)
+    {
+        Notifier<> notifier;
+        NotifierConnection first, second;
+        int calls = 0;
+
+        first = notifier.connect([&]() {
+            calls++;
+            first.disconnect();
+            second.disconnect();
+        });
+        second = notifier.connect([&calls]() { calls++; });
+
+        notifier.notify();
+        notifier.notify();
+        EXPECT_EQ(calls, 1);
+    }
+
+    TEST(Notifier, TakeOverKeepsConnections)
+    {
+        Notifier<std::string> notifier1;
+        Notifier<std::string> notifier2;
+
+        CallCounter<std::string> cc;
+        {
+            auto connection = notifier2.connect(std::ref(cc));
+            notifier1.takeOverSubscriptions(notifier2);
+            EXPECT_TRUE(connection.isConnected());
+
+            notifier1.notify("");
+            EXPECT_EQ(cc.callCount, 1);
+        }
+        notifier1.notify("");
+        EXPECT_EQ(cc.callCount, 1);
+    }
+
+    TEST(Notifier, IdleNotifierDoesNotAllocate)
+    {
+        EXPECT_EQ(sizeof(Notifier<std::string>), sizeof(void *));
+
+        AllocationCounter counter;
+        Notifier<std::string> notifier;
+        notifier.notify("");
+        notifier.unsubscribeAll();
+        EXPECT_EQ(counter.allocations(), 0u);
+
+        auto subscription = notifier.subscribe([](auto) {});
+        EXPECT_GT(counter.allocations(), 0u);
+        notifier.unsubscribe(subscription);
+    }
+
+    TEST(Notifier, NotifyDoesNotAllocate)
+    {
+        Notifier<int> notifier;
+        int sum = 0;
+        for (int i = 0; i < 10; i++) {
+            notifier.subscribe([&sum](int value) { sum += value; });
+        }
+
+        AllocationCounter counter;
+        notifier.notify(1);
+        EXPECT_EQ(counter.allocations(), 0u);
+        EXPECT_EQ(sum, 10);
+    }
+
+    TEST(Notifier, DISABLED_Benchmark)
+    {
+        for (int numberOfSubscribers : {1, 10, 1000}) {
+            const int rounds = 1000000 / numberOfSubscribers;
+            int calls = 0;
+            std::vector<Notifier<int>::Subscription> subscriptions(numberOfSubscribers);
+
+            double subscribeTime = 0;
+            double notifyTime = 0;
+            double unsubscribeTime = 0;
+
+            for (int round = 0; round < rounds; round++) {
+                Notifier<int> notifier;
+
+                StopWatch subscribeWatch;
+                for (auto &subscription : subscriptions) {
+                    subscription = notifier.subscribe([&calls](int value) { calls += value; });
+                }
+                subscribeTime += subscribeWatch.elapsed().count();
+
+                StopWatch notifyWatch;
+                notifier.notify(1);
+                notifyTime += notifyWatch.elapsed().count();
+
+                StopWatch unsubscribeWatch;
+                for (auto &subscription : subscriptions) {
+                    notifier.unsubscribe(subscription);
+                }
+                unsubscribeTime += unsubscribeWatch.elapsed().count();
+            }
+
+            EXPECT_EQ(calls, rounds * numberOfSubscribers);
+
+            double operations = double(rounds) * numberOfSubscribers;
+            logstream() << numberOfSubscribers << " subscribers, per subscriber: subscribe "
+                        << (int)(subscribeTime / operations * 1e9) << "ns, notify "
+                        << (int)(notifyTime / operations * 1e9) << "ns, unsubscribe "
+                        << (int)(unsubscribeTime / operations * 1e9) << "ns";
+        }
+    }
 }
@@ -1,8 +1,17 @@
 #include <gtest/gtest.h>
 
+#include "AllocationCounter.h"
+
+#include <bdn/DispatchQueue.h>
+#include <bdn/Rect.h>
+#include <bdn/StopWatch.h>
+#include <bdn/log.h>
 #include <bdn/property/Property.h>
+#include <future>
+#include <thread>
 
 using namespace std::string_literals;
+using namespace std::chrono_literals;
 
 namespace bdn
 {
@@ -134,6 +143,72 @@ namespace bdn
         EXPECT_EQ("Test", p2.get());
     }
 
+    TEST(Property, CrossThreadBindingCoalesces)
+    {
+        auto queue = std::make_shared<DispatchQueue>();
+        Property<int> source(0);
+        Property<int> target;
+
+        std::atomic<int> sets{0};
+        std::promise<void> done;
+        target.onChange() += [&sets, &done](auto &property) {
+            sets++;
+            if (property.get() == 1000) {
+                done.set_value();
+            }
+        };
+
+        target.bind(source, queue);
+
+        // Keep the queue busy, so that all updates arrive within one frame
+        std::promise<void> blocking, release;
+        queue->dispatchAsync([&blocking, releaseFuture = release.get_future()]() {
+            blocking.set_value();
+            releaseFuture.wait();
+        });
+        blocking.get_future().wait();
+
+        std::thread worker([&source]() {
+            for (int i = 1; i <= 1000; i++) {
+                source = i;
+            }
+        });
+        worker.join();
+        release.set_value();
+
+        ASSERT_EQ(done.get_future().wait_for(5s), std::future_status::ready);
+        EXPECT_EQ(sets, 1);
+    }
+
+    TEST(Property, CrossThreadBindingThrottles)
+    {
+        auto queue = std::make_shared<DispatchQueue>();
+        Property<int> source(0);
+        Property<int> target;
+
+        std::atomic<int> sets{0};
+        std::promise<void> done;
+        target.onChange() += [&sets, &done](auto &property) {
+            sets++;
+            if (property.get() == 100) {
+                done.set_value();
+            }
+        };
+
+        target.bind(source, queue, 50ms);
+
+        std::thread worker([&source]() {
+            for (int i = 1; i <= 100; i++) {
+                source = i;
+                std::this_thread::sleep_for(1ms);
+            }
+        });
+        worker.join();
+
+        ASSERT_EQ(done.get_future().wait_for(5s), std::future_status::ready);
+        EXPECT_LT(sets, 20);
+    }
+
     TEST(Property, OverrideValueInOnChange)
     {
         Property<std::string> p1;
@@ -158,4 +233,143 @@ namespace bdn
         Property<std::string> p2(SetterBacking<std::string>("Hello World"));
         EXPECT_EQ("Hello World", p2.get());
     }
+
+    TEST(Property, PlainValueDoesNotAllocate)
+    {
+        AllocationCounter counter;
+        Property<int> property = 1;
+        property = 2;
+
+        ChangeCounter<int> changeCounter;
+        property.onChange() += std::ref(changeCounter);
+        property = 3;
+        EXPECT_EQ(changeCounter.changeCount, 1);
+
+        // Only the subscriber storage of the notifier
+        EXPECT_EQ(counter.allocations(), 1u);
+    }
+
+    TEST(Property, BackingIsCreatedOnDemand)
+    {
+        Property<std::string> property = "Hello"s;
+        ChangeCounter<std::string> changeCounter;
+        property.onChange() += std::ref(changeCounter);
+
+        auto backing = property.backing();
+        EXPECT_EQ(backing, property.backing());
+        EXPECT_EQ(backing->get(), "Hello"s);
+
+        // Subscribers of the property keep being notified through the backing
+        backing->set("World"s);
+        EXPECT_EQ(property.get(), "World"s);
+        EXPECT_EQ(changeCounter.changeCount, 1);
+
+        Property<std::string> source = "Bound"s;
+        Property<std::string> target;
+        target.bind(source);
+        EXPECT_EQ(target.get(), "Bound"s);
+        source = "Changed"s;
+        EXPECT_EQ(target.get(), "Changed"s);
+    }
+
+    struct CopyCounter
+    {
+        CopyCounter() = default;
+        CopyCounter(const CopyCounter &) { copies++; }
+        CopyCounter &operator=(const CopyCounter &) = default;
+
+        bool operator!=(const CopyCounter &) const { return true; }
+        size_t size() const { return 42; }
+
+        static int copies;
+    };
+    int CopyCounter::copies = 0;
+
+    TEST(Property, ReadDoesNotCopy)
+    {
+        Property<CopyCounter> inlineValue;
+        Property<CopyCounter> backed(std::make_shared<ValueBacking<CopyCounter>>());
+
+        for (auto *property : {&inlineValue, &backed}) {
+            CopyCounter::copies = 0;
+
+            EXPECT_EQ(property->read([](const CopyCounter &value) { return value.size(); }), 42u);
+            EXPECT_EQ((*property)->size(), 42u);
+            EXPECT_EQ(CopyCounter::copies, 0);
+
+            property->get();
+            EXPECT_EQ(CopyCounter::copies, 1);
+        }
+
+        // Computed values are read through a temporary copy
+        int value = 1;
+        Property<int> computed(GetterSetterBacking<int>([&]() { return value; }, [](const int &) { return false; }));
+        EXPECT_EQ(computed.read([](const int &v) { return v + 1; }), 2);
+    }
+
+    TEST(Property, DISABLED_GetSetBenchmark)
+    {
+        const int iterations = 1000000;
+
+        Property<int> plain;
+        Property<int> backed(std::make_shared<ValueBacking<int>>());
+
+        auto measure = [&](Property<int> &property) {
+            StopWatch watch;
+            int sum = 0;
+            for (int i = 0; i < iterations; i++) {
+                property = i;
+                sum += property.get();
+            }
+            EXPECT_NE(sum, 0);
+            return watch.elapsed().count() / iterations * 1e9;
+        };
+
+        double plainTime = measure(plain);
+        double backedTime = measure(backed);
+
+        StopWatch constructionWatch;
+        for (int i = 0; i < iterations; i++) {
+            Property<int> property = i;
+            EXPECT_EQ(property.get(), i);
+        }
+        double constructionTime = constructionWatch.elapsed().count() / iterations * 1e9;
+
+        logstream() << "Property<int> set + get, inline: " << (int)plainTime << "ns, ValueBacking: " << (int)backedTime
+                    << "ns, construction: " << (int)constructionTime << "ns";
+    }
+
+    TEST(Property, DISABLED_BindBenchmark)
+    {
+        // Roughly what View::bindViewCore() does for a tree of 1000 views
+        const int numberOfPairs = 1000;
+
+        std::vector<Property<Rect>> sources(numberOfPairs);
+        std::vector<Property<Rect>> targets(numberOfPairs);
+        for (int i = 0; i < numberOfPairs; i++) {
+            sources[i].backing();
+            targets[i].backing();
+        }
+
+        AllocationCounter counter;
+        StopWatch bindWatch;
+        for (int i = 0; i < numberOfPairs; i++) {
+            targets[i].bind(sources[i]);
+        }
+        double bindTime = bindWatch.elapsed().count() / numberOfPairs * 1e9;
+        size_t allocations = counter.allocations();
+
+        sources[0] = Rect{1, 2, 3, 4};
+        EXPECT_EQ(targets[0].get(), (Rect{1, 2, 3, 4}));
+
+        StopWatch unbindWatch;
+        for (int i = 0; i < numberOfPairs; i++) {
+            targets[i].backing()->unbind();
+            sources[i].backing()->unbind();
+        }
+        double unbindTime = unbindWatch.elapsed().count() / numberOfPairs * 1e9;
+
+        logstream() << "Bidirectional bind: " << (int)bindTime << "ns, " << double(allocations) / numberOfPairs
+                    << " allocations, unbind: " << (int)unbindTime << "ns";
+    }
 }
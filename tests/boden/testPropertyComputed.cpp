@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <bdn/property/Property.h>
+
+#include <vector>
+
+using namespace std::string_literals;
+
+namespace bdn
+{
+    TEST(ComputedBacking, MultipleSources)
+    {
+        Property<std::string> firstName("Jane"s);
+        Property<std::string> lastName("Doe"s);
+        Property<int> age(42);
+
+        Property<std::string> description =
+            makeComputed([](const std::string &first, const std::string &last,
+                            int years) { return first + " " + last + " (" + std::to_string(years) + ")"; },
+                         firstName, lastName, age);
+
+        EXPECT_EQ(description.get(), "Jane Doe (42)");
+
+        int changeCount = 0;
+        description.onChange() += [&changeCount](auto &) { changeCount++; };
+
+        lastName = "Roe"s;
+        EXPECT_EQ(changeCount, 1);
+        EXPECT_EQ(description.get(), "Jane Roe (42)");
+
+        age = 43;
+        EXPECT_EQ(changeCount, 2);
+        EXPECT_EQ(description.get(), "Jane Roe (43)");
+    }
+
+    TEST(ComputedBacking, ComputesLazilyAndCaches)
+    {
+        Property<int> a(1);
+        Property<int> b(2);
+        int computeCount = 0;
+
+        Property<int> sum = makeComputed(
+            [&computeCount](int x, int y) {
+                computeCount++;
+                return x + y;
+            },
+            a, b);
+
+        EXPECT_EQ(computeCount, 0);
+        EXPECT_EQ(sum.get(), 3);
+        EXPECT_EQ(sum.get(), 3);
+        EXPECT_EQ(computeCount, 1);
+
+        a = 10;
+        b = 20;
+        EXPECT_EQ(computeCount, 1);
+        EXPECT_EQ(sum.get(), 30);
+        EXPECT_EQ(computeCount, 2);
+    }
+
+    TEST(ComputedBacking, DiamondIsGlitchFree)
+    {
+        // source -> left, right -> bottom
+        Property<int> source(1);
+        Property<int> left = makeComputed([](int value) { return value * 2; }, source);
+        Property<int> right = makeComputed([](int value) { return value * 3; }, source);
+        Property<int> bottom = makeComputed([](int l, int r) { return l + r; }, left, right);
+
+        EXPECT_EQ(bottom.get(), 5);
+
+        std::vector<int> seen;
+        bottom.onChange() += [&seen](auto &property) { seen.push_back(property.get()); };
+
+        source = 2;
+        EXPECT_EQ(seen, std::vector<int>{10});
+
+        source = 3;
+        EXPECT_EQ(seen, (std::vector<int>{10, 15}));
+    }
+
+    TEST(ComputedBacking, NotifiesInTopologicalOrder)
+    {
+        Property<int> source(1);
+        Property<int> first = makeComputed([](int value) { return value + 1; }, source);
+        Property<int> second = makeComputed([](int value) { return value + 1; }, first);
+        Property<int> combined = makeComputed([](int s, int f) { return s * f; }, source, second);
+
+        std::vector<std::string> order;
+        combined.onChange() += [&order](auto &) { order.push_back("combined"); };
+        second.onChange() += [&order](auto &) { order.push_back("second"); };
+        first.onChange() += [&order](auto &) { order.push_back("first"); };
+
+        source = 2;
+        EXPECT_EQ(order, (std::vector<std::string>{"first", "second", "combined"}));
+        EXPECT_EQ(combined.get(), 8);
+    }
+
+    TEST(ComputedBacking, IsReadOnly)
+    {
+        Property<int> source(1);
+        Property<int> doubled = makeComputed([](int value) { return value * 2; }, source);
+
+        doubled = 100;
+        EXPECT_EQ(doubled.get(), 2);
+        EXPECT_EQ(source.get(), 1);
+    }
+}
@@ -2,6 +2,9 @@
 
 #include <bdn/property/Property.h>
 
+#include <limits>
+#include <sstream>
+
 using namespace std::string_literals;
 
 namespace bdn
@@ -127,4 +130,45 @@ namespace bdn
 
         EXPECT_EQ("There are 42 messages", StreamingBackingProperty.get());
     }
+
+    TEST(StreamBacking, FormatsLikeOstream)
+    {
+        Property<int> integer = -42;
+        Property<unsigned long long> large = std::numeric_limits<unsigned long long>::max();
+        Property<double> real = 1.0 / 3.0;
+        Property<float> small = 1.5e-7f;
+        Property<bool> flag = true;
+        Property<char> character = 'x';
+
+        Property<std::string> pStream = {StreamBacking() << integer << " " << large << " " << real << " " << small
+                                                         << " " << flag << " " << character << " " << 2.5};
+
+        std::ostringstream expected;
+        expected << -42 << " " << std::numeric_limits<unsigned long long>::max() << " " << 1.0 / 3.0 << " " << 1.5e-7f
+                 << " " << true << " " << 'x' << " " << 2.5;
+        EXPECT_EQ(pStream.get(), expected.str());
+
+        real = 1e20;
+        expected.str("");
+        expected << -42 << " " << std::numeric_limits<unsigned long long>::max() << " " << 1e20 << " " << 1.5e-7f << " "
+                 << true << " " << 'x' << " " << 2.5;
+        EXPECT_EQ(pStream.get(), expected.str());
+    }
+
+    TEST(StreamBacking, OnlyNotifiesWhenTextChanges)
+    {
+        ChangeCounter<std::string> cc;
+        Property<double> value = 1.0;
+        Property<std::string> pStream = {StreamBacking() << "Value: " << value};
+        pStream.onChange() += std::ref(cc);
+
+        // Renders as "1" like before
+        value = 1.0000001;
+        EXPECT_EQ(pStream.get(), "Value: 1");
+        EXPECT_EQ(cc.changeCount, 0);
+
+        value = 2.0;
+        EXPECT_EQ(pStream.get(), "Value: 2");
+        EXPECT_EQ(cc.changeCount, 1);
+    }
 }
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <bdn/property/Property.h>
+#include <bdn/property/PropertyTransaction.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace bdn
+{
+    TEST(PropertyTransaction, DefersAndCollapsesNotifications)
+    {
+        Property<int> a;
+        Property<std::string> b;
+
+        std::vector<std::string> notifications;
+        a.onChange() += [&](auto &property) { notifications.push_back("a=" + std::to_string(property.get())); };
+        b.onChange() += [&](auto &property) { notifications.push_back("b=" + property.get()); };
+
+        {
+            PropertyTransaction transaction;
+            EXPECT_TRUE(PropertyTransaction::isActive());
+
+            a = 1;
+            b = "x";
+            a = 2;
+            a = 3;
+            EXPECT_TRUE(notifications.empty());
+        }
+
+        EXPECT_FALSE(PropertyTransaction::isActive());
+        EXPECT_EQ(notifications, (std::vector<std::string>{"a=3", "b=x"}));
+    }
+
+    TEST(PropertyTransaction, NestedTransactionsDeliverOnce)
+    {
+        Property<int> property;
+        int changes = 0;
+        property.onChange() += [&](auto &) { changes++; };
+
+        PropertyTransaction outer;
+        {
+            PropertyTransaction inner;
+            property = 1;
+        }
+        EXPECT_EQ(changes, 0);
+
+        property = 2;
+        outer.commit();
+        EXPECT_EQ(changes, 1);
+
+        property = 3;
+        EXPECT_EQ(changes, 2);
+    }
+
+    TEST(PropertyTransaction, BatchesCascadingChanges)
+    {
+        Property<int> source;
+        Property<int> derivedA;
+        Property<int> derivedB;
+        Property<int> sum;
+
+        source.onChange() += [&](auto &property) {
+            derivedA = property.get() * 2;
+            derivedB = property.get() * 3;
+        };
+        derivedA.onChange() += [&](auto &) { sum = derivedA.get() + derivedB.get(); };
+        derivedB.onChange() += [&](auto &) { sum = derivedA.get() + derivedB.get(); };
+
+        std::vector<int> sums;
+        sum.onChange() += [&](auto &property) { sums.push_back(property.get()); };
+
+        {
+            PropertyTransaction transaction;
+            source = 1;
+        }
+
+        // Without the transaction sum would first be 2 + 0, then 2 + 3
+        EXPECT_EQ(sums, (std::vector<int>{5}));
+    }
+
+    TEST(PropertyTransaction, DestroyedBackingIsSkipped)
+    {
+        PropertyTransaction transaction;
+
+        {
+            auto property = std::make_unique<Property<int>>();
+            property->onChange() += [](auto &) { FAIL(); };
+            *property = 1;
+        }
+
+        Property<int> other;
+        int changes = 0;
+        other.onChange() += [&](auto &) { changes++; };
+        other = 1;
+
+        transaction.commit();
+        EXPECT_EQ(changes, 1);
+    }
+}
@@ -0,0 +1,250 @@
+#include <bdn/StopWatch.h>
+#include <bdn/TimerWheel.h>
+#include <bdn/log.h>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <map>
+#include <queue>
+#include <random>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace bdn
+{
+    using TestWheel = TimerWheel<int>;
+
+    static std::vector<int> takeAllDue(TestWheel &wheel, TestWheel::TimePoint now, bool rearm = false)
+    {
+        std::vector<int> result;
+
+        TestWheel::Id id;
+        int payload;
+        while (wheel.takeDue(id, payload)) {
+            result.push_back(payload);
+            wheel.finish(id, payload, rearm, now);
+        }
+        return result;
+    }
+
+    TEST(TimerWheel, Init)
+    {
+        TestWheel wheel;
+        EXPECT_TRUE(wheel.empty());
+        EXPECT_FALSE(wheel.nextExpiry());
+    }
+
+    TEST(TimerWheel, ExpiresInOrder)
+    {
+        auto start = TestWheel::Clock::now();
+        TestWheel wheel(start);
+
+        std::vector<int> delays = {5, 1, 63, 64, 65, 100, 4095, 4096, 5000, 300000};
+        for (int delay : delays) {
+            wheel.add(start + std::chrono::milliseconds(delay), delay);
+        }
+        EXPECT_EQ(wheel.size(), delays.size());
+
+        std::vector<int> fired;
+        for (int ms = 0; ms <= 300000; ms++) {
+            auto now = start + std::chrono::milliseconds(ms);
+            wheel.advance(now);
+            for (int payload : takeAllDue(wheel, now)) {
+                // Never early, never late
+                EXPECT_EQ(payload, ms);
+                fired.push_back(payload);
+            }
+        }
+
+        std::sort(delays.begin(), delays.end());
+        EXPECT_EQ(fired, delays);
+        EXPECT_TRUE(wheel.empty());
+    }
+
+    TEST(TimerWheel, SkipsAheadInLargeSteps)
+    {
+        auto start = TestWheel::Clock::now();
+        TestWheel wheel(start);
+
+        std::mt19937 random(42);
+        std::vector<int> delays;
+        for (int i = 0; i < 1000; i++) {
+            delays.push_back(random() % 10000000);
+            wheel.add(start + std::chrono::milliseconds(delays.back()), delays.back());
+        }
+
+        std::vector<int> fired;
+        for (auto now = start; fired.size() < delays.size(); now += 997ms) {
+            wheel.advance(now);
+            for (int payload : takeAllDue(wheel, now)) {
+                EXPECT_LE(start + std::chrono::milliseconds(payload), now);
+                EXPECT_GT(start + std::chrono::milliseconds(payload) + 997ms, now);
+                fired.push_back(payload);
+            }
+        }
+
+        std::sort(delays.begin(), delays.end());
+        EXPECT_EQ(fired, delays);
+    }
+
+    TEST(TimerWheel, Overflow)
+    {
+        auto start = TestWheel::Clock::now();
+        TestWheel wheel(start);
+
+        // Beyond the range of the highest level
+        wheel.add(start + 10h, 1);
+
+        wheel.advance(start + 10h - 1ms);
+        EXPECT_TRUE(takeAllDue(wheel, start + 10h - 1ms).empty());
+
+        wheel.advance(start + 10h);
+        EXPECT_EQ(takeAllDue(wheel, start + 10h), std::vector<int>{1});
+    }
+
+    TEST(TimerWheel, NextExpiry)
+    {
+        auto start = TestWheel::Clock::now();
+        TestWheel wheel(start);
+
+        wheel.add(start + 10ms, 1);
+        EXPECT_EQ(*wheel.nextExpiry(), start + 10ms);
+
+        wheel.add(start + 5ms, 2);
+        EXPECT_EQ(*wheel.nextExpiry(), start + 5ms);
+
+        // Entries on higher levels report the time they have to be cascaded
+        TestWheel far(start);
+        far.add(start + 10000ms, 1);
+        auto next = far.nextExpiry();
+        ASSERT_TRUE(next);
+        EXPECT_LE(*next, start + 10000ms);
+
+        while (!far.empty()) {
+            far.advance(*far.nextExpiry());
+            takeAllDue(far, *far.nextExpiry());
+        }
+    }
+
+    TEST(TimerWheel, Cancel)
+    {
+        auto start = TestWheel::Clock::now();
+        TestWheel wheel(start);
+
+        auto a = wheel.add(start + 10ms, 1);
+        auto b = wheel.add(start + 10ms, 2);
+        auto c = wheel.add(start + 10000ms, 3);
+
+        EXPECT_TRUE(wheel.cancel(a));
+        EXPECT_FALSE(wheel.cancel(a));
+        EXPECT_TRUE(wheel.cancel(c));
+        EXPECT_EQ(wheel.size(), 1u);
+
+        wheel.advance(start + 20000ms);
+        EXPECT_EQ(takeAllDue(wheel, start + 20000ms), std::vector<int>{2});
+        EXPECT_FALSE(wheel.cancel(b));
+    }
+
+    TEST(TimerWheel, StaleIdDoesNotCancelReusedSlot)
+    {
+        auto start = TestWheel::Clock::now();
+        TestWheel wheel(start);
+
+        auto a = wheel.add(start + 10ms, 1);
+        EXPECT_TRUE(wheel.cancel(a));
+
+        auto b = wheel.add(start + 10ms, 2);
+        EXPECT_FALSE(wheel.cancel(a));
+
+        wheel.advance(start + 10ms);
+        EXPECT_EQ(takeAllDue(wheel, start + 10ms), std::vector<int>{2});
+        EXPECT_FALSE(wheel.cancel(b));
+    }
+
+    TEST(TimerWheel, Periodic)
+    {
+        auto start = TestWheel::Clock::now();
+        TestWheel wheel(start);
+
+        auto id = wheel.add(start + 10ms, 1, 10ms);
+
+        int calls = 0;
+        for (int ms = 0; ms <= 100; ms++) {
+            auto now = start + std::chrono::milliseconds(ms);
+            wheel.advance(now);
+            calls += takeAllDue(wheel, now, true).size();
+        }
+        EXPECT_EQ(calls, 10);
+
+        EXPECT_TRUE(wheel.cancel(id));
+        EXPECT_TRUE(wheel.empty());
+    }
+
+    TEST(TimerWheel, CancelWhileFiring)
+    {
+        auto start = TestWheel::Clock::now();
+        TestWheel wheel(start);
+
+        wheel.add(start + 10ms, 1, 10ms);
+        wheel.advance(start + 10ms);
+
+        TestWheel::Id id;
+        int payload;
+        ASSERT_TRUE(wheel.takeDue(id, payload));
+
+        EXPECT_TRUE(wheel.cancel(id));
+        wheel.finish(id, payload, true, start + 10ms);
+
+        EXPECT_TRUE(wheel.empty());
+    }
+
+    TEST(TimerWheel, DISABLED_InsertCancelBenchmark)
+    {
+        const int numberOfTimers = 100000;
+
+        std::mt19937 random(1);
+        std::vector<std::chrono::milliseconds> delays;
+        for (int i = 0; i < numberOfTimers; i++) {
+            delays.emplace_back(random() % 60000);
+        }
+
+        auto start = TestWheel::Clock::now();
+
+        double wheelTime;
+        {
+            TestWheel wheel(start);
+            std::vector<TestWheel::Id> ids;
+            ids.reserve(numberOfTimers);
+
+            StopWatch watch;
+            for (int i = 0; i < numberOfTimers; i++) {
+                ids.push_back(wheel.add(start + delays[i], i));
+            }
+            for (auto id : ids) {
+                wheel.cancel(id);
+            }
+            wheelTime = watch.elapsed().count();
+        }
+
+        // What DispatchQueue used before
+        double mapTime;
+        {
+            std::map<TestWheel::TimePoint, std::queue<int>> map;
+
+            StopWatch watch;
+            for (int i = 0; i < numberOfTimers; i++) {
+                map[start + delays[i]].push(i);
+            }
+            for (int i = 0; i < numberOfTimers; i++) {
+                auto it = map.find(start + delays[i]);
+                if (it != map.end()) {
+                    map.erase(it);
+                }
+            }
+            mapTime = watch.elapsed().count();
+        }
+
+        logstream() << numberOfTimers << " timers added and cancelled, TimerWheel: " << (int)(wheelTime * 1000)
+                    << "ms, std::map: " << (int)(mapTime * 1000) << "ms";
+    }
+}
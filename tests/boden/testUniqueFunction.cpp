@@ -0,0 +1,199 @@
+#include "AllocationCounter.h"
+
+#include <array>
+#include <bdn/DispatchQueue.h>
+#include <bdn/UniqueFunction.h>
+#include <bdn/WeakCallback.h>
+#include <functional>
+#include <future>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+
+namespace bdn
+{
+    TEST(UniqueFunction, Empty)
+    {
+        UniqueFunction<void()> function;
+        EXPECT_FALSE(function);
+        EXPECT_TRUE(function == nullptr);
+        EXPECT_THROW(function(), std::bad_function_call);
+
+        UniqueFunction<void()> fromEmptyStdFunction = std::function<void()>();
+        EXPECT_FALSE(fromEmptyStdFunction);
+
+        void (*nullFunctionPointer)() = nullptr;
+        UniqueFunction<void()> fromNullPointer = nullFunctionPointer;
+        EXPECT_FALSE(fromNullPointer);
+    }
+
+    TEST(UniqueFunction, Call)
+    {
+        UniqueFunction<int(int, int)> add = [](int a, int b) { return a + b; };
+        EXPECT_TRUE(add);
+        EXPECT_EQ(add(2, 3), 5);
+
+        std::string suffix = "!";
+        UniqueFunction<std::string(const std::string &)> exclaim = [suffix](const std::string &s) {
+            return s + suffix;
+        };
+        EXPECT_EQ(exclaim("Hello"), "Hello!");
+    }
+
+    TEST(UniqueFunction, MoveOnlyCallable)
+    {
+        auto value = std::make_unique<int>(42);
+        UniqueFunction<int()> function = [value = std::move(value)]() { return *value; };
+
+        UniqueFunction<int()> moved = std::move(function);
+        EXPECT_FALSE(function);
+        EXPECT_EQ(moved(), 42);
+
+        std::packaged_task<int()> task([]() { return 7; });
+        auto future = task.get_future();
+        UniqueFunction<void()> runTask = std::move(task);
+        runTask();
+        EXPECT_EQ(future.get(), 7);
+    }
+
+    TEST(UniqueFunction, DestroysCallable)
+    {
+        auto tracker = std::make_shared<int>(0);
+        std::weak_ptr<int> weakTracker = tracker;
+
+        {
+            UniqueFunction<void()> function = [tracker = std::move(tracker)]() {};
+            EXPECT_FALSE(weakTracker.expired());
+
+            UniqueFunction<void()> other = std::move(function);
+            EXPECT_FALSE(weakTracker.expired());
+
+            other = nullptr;
+            EXPECT_TRUE(weakTracker.expired());
+        }
+    }
+
+    TEST(UniqueFunction, SmallLambdaDoesNotAllocate)
+    {
+        int a = 1, b = 2, c = 3;
+        void *context = &a;
+        double factor = 2.0;
+
+        // A typical lambda capturing a handful of pointers and values
+        auto lambda = [&a, &b, &c, context, factor]() { a = static_cast<int>((b + c) * factor) + (context ? 1 : 0); };
+        static_assert(UniqueFunction<void()>::storedInline<decltype(lambda)>());
+
+        AllocationCounter counter;
+
+        UniqueFunction<void()> function = lambda;
+        UniqueFunction<void()> moved = std::move(function);
+        moved();
+        moved = nullptr;
+
+        EXPECT_EQ(counter.allocations(), 0u);
+        EXPECT_EQ(a, 11);
+    }
+
+    TEST(UniqueFunction, LargeLambdaAllocatesOnce)
+    {
+        std::array<char, 128> large{};
+        auto lambda = [large]() { return large[0]; };
+        static_assert(!UniqueFunction<char()>::storedInline<decltype(lambda)>());
+
+        AllocationCounter counter;
+
+        UniqueFunction<char()> function = lambda;
+        UniqueFunction<char()> moved = std::move(function);
+        moved();
+
+        EXPECT_EQ(counter.allocations(), 1u);
+    }
+
+    TEST(UniqueFunction, DispatchAsyncAllocatesOnlyTheQueueNode)
+    {
+        DispatchQueue queue;
+
+        int a = 0, b = 0;
+        auto flag = std::make_shared<bool>(false);
+        std::promise<void> done;
+        auto doneFuture = done.get_future();
+
+        // Make sure the worker is up and idle before counting
+        queue.dispatchSync([]() {});
+
+        size_t allocations;
+        {
+            AllocationCounter counter;
+            queue.dispatchAsync([&a, &b, flag, &done]() {
+                a = b + 1;
+                *flag = true;
+                done.set_value();
+            });
+            allocations = counter.allocations();
+        }
+
+        doneFuture.wait();
+        EXPECT_TRUE(*flag);
+
+        EXPECT_EQ(allocations, 1u);
+    }
+
+    TEST(UniqueFunction, WeakCallback)
+    {
+        WeakCallback<int(int)> callback(-1);
+
+        {
+            auto unique = std::make_unique<int>(10);
+            auto receiver = callback.set([unique = std::move(unique)](int value) { return value + *unique; });
+            EXPECT_EQ(callback.fire(5), 15);
+        }
+
+        EXPECT_EQ(callback.fire(5), -1);
+    }
+
+    TEST(UniqueFunction, WeakCallbackOutlivesReceiver)
+    {
+        WeakCallback<void()> callback;
+        int calls = 0;
+
+        WeakCallback<void()>::Receiver receiver = callback.set([&calls]() { calls++; });
+        callback.fire();
+
+        // A moved receiver keeps the function connected
+        auto moved = std::move(receiver);
+        callback.fire();
+        EXPECT_EQ(calls, 2);
+
+        moved.reset();
+        callback.fire();
+        EXPECT_EQ(calls, 2);
+    }
+
+    TEST(UniqueFunction, WeakCallbackReceiverDestroyedDuringFire)
+    {
+        WeakCallback<int()> callback(-1);
+        auto receiver = std::make_unique<WeakCallback<int()>::Receiver>();
+
+        auto value = std::make_shared<int>(42);
+        *receiver = callback.set([&receiver, value]() {
+            receiver.reset();
+            // The function is kept alive until fire() returns
+            return *value;
+        });
+
+        EXPECT_EQ(callback.fire(), 42);
+        EXPECT_EQ(value.use_count(), 1);
+        EXPECT_EQ(callback.fire(), -1);
+    }
+
+    TEST(UniqueFunction, WeakCallbackDestroyedFirst)
+    {
+        WeakCallback<void()>::Receiver receiver;
+        {
+            WeakCallback<void()> callback;
+            receiver = callback.set([]() {});
+            EXPECT_TRUE(receiver);
+        }
+        EXPECT_FALSE(receiver);
+    }
+}
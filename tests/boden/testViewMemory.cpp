@@ -0,0 +1,83 @@
+#include "AllocationCounter.h"
+
+#include <bdn/Application.h>
+#include <bdn/StopWatch.h>
+#include <bdn/log.h>
+#include <bdn/ui/Button.h>
+#include <bdn/ui/Label.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace bdn
+{
+    using namespace bdn::ui;
+
+    template <class ViewType> size_t measureViewMemory(const char *name)
+    {
+        const int numberOfViews = 100;
+
+        std::vector<std::shared_ptr<ViewType>> views;
+        views.reserve(numberOfViews);
+
+        AllocationCounter counter;
+        StopWatch watch;
+        for (int i = 0; i < numberOfViews; i++) {
+            views.push_back(std::make_shared<ViewType>());
+        }
+        auto elapsed = watch.elapsed();
+        size_t bytes = counter.bytes() / numberOfViews;
+        size_t allocations = counter.allocations() / numberOfViews;
+
+        logstream() << name << ": " << bytes << " bytes in " << allocations << " allocations per view, "
+                    << sizeof(ViewType) << " of them inline, "
+                    << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / numberOfViews
+                    << "ns to construct";
+
+        return bytes;
+    }
+
+    TEST(ViewMemory, ButtonAndLabel)
+    {
+        bdn::App()->dispatchQueue()->dispatchSync([=]() {
+            // Views are created without a core here, so this is what the
+            // view itself and its properties cost.
+            EXPECT_GT(measureViewMemory<Button>("Button"), sizeof(Button));
+            EXPECT_GT(measureViewMemory<Label>("Label"), sizeof(Label));
+        });
+    }
+
+    TEST(ViewMemory, DISABLED_BindViewCoreBenchmark)
+    {
+        bdn::App()->dispatchQueue()->dispatchSync([=]() {
+            const int numberOfViews = 1000;
+
+            std::vector<std::shared_ptr<Label>> views;
+            views.reserve(numberOfViews);
+            for (int i = 0; i < numberOfViews; i++) {
+                views.push_back(std::make_shared<Label>());
+            }
+
+            // Creates the cores, which binds each view to its core
+            AllocationCounter counter;
+            StopWatch bindWatch;
+            for (auto &view : views) {
+                EXPECT_NE(view->viewCore(), nullptr);
+            }
+            auto bindTime = bindWatch.elapsed();
+            size_t allocations = counter.allocations() / numberOfViews;
+
+            StopWatch teardownWatch;
+            views.clear();
+            auto teardownTime = teardownWatch.elapsed();
+
+            logstream() << "Label core creation and binding: "
+                        << std::chrono::duration_cast<std::chrono::nanoseconds>(bindTime).count() / numberOfViews
+                        << "ns in " << allocations << " allocations per view, teardown: "
+                        << std::chrono::duration_cast<std::chrono::nanoseconds>(teardownTime).count() / numberOfViews
+                        << "ns per view";
+        });
+    }
+}
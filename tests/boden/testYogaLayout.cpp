@@ -0,0 +1,285 @@
+#include <gtest/gtest.h>
+
+#include <bdn/Application.h>
+#include <bdn/StopWatch.h>
+#include <bdn/log.h>
+#include <bdn/ui/ContainerView.h>
+#include <bdn/ui/ViewCoreFactory.h>
+#include <bdn/ui/yoga/FlexStylesheet.h>
+#include <bdn/ui/yoga/Layout.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace bdn
+{
+    using namespace bdn::ui;
+
+    namespace
+    {
+        /** A container core without a platform view, so that layout can be
+            measured on its own. */
+        class HeadlessContainerCore : public View::Core, public ContainerView::Core
+        {
+          public:
+            using View::Core::Core;
+
+            void init() override {}
+            float pointScaleFactor() const override { return 1.0f; }
+            void scheduleLayout() override { scheduledLayouts++; }
+
+            void addChildView(std::shared_ptr<View> child) override { _children.push_back(std::move(child)); }
+            void removeChildView(std::shared_ptr<View> child) override
+            {
+                _children.erase(std::remove(_children.begin(), _children.end(), child), _children.end());
+            }
+            std::vector<std::shared_ptr<View>> childViews() const override { return _children; }
+
+          public:
+            int scheduledLayouts = 0;
+
+          private:
+            std::vector<std::shared_ptr<View>> _children;
+        };
+
+        /** A leaf view of constant size that counts its measurements */
+        class MeasuredView : public View
+        {
+          public:
+            using View::View;
+        };
+
+        class HeadlessLeafCore : public View::Core
+        {
+          public:
+            using View::Core::Core;
+
+            void init() override {}
+            float pointScaleFactor() const override { return 1.0f; }
+            void scheduleLayout() override {}
+
+            Size sizeForSpace(Size availableSpace) const override
+            {
+                measurements++;
+                return Size{100, 20};
+            }
+
+          public:
+            mutable int measurements = 0;
+        };
+
+        std::shared_ptr<ViewCoreFactory> headlessViewCoreFactory()
+        {
+            auto factory = std::make_shared<ViewCoreFactory>();
+            // The first registration wins, so ContainerView keeps this one
+            factory->registerCoreType<HeadlessContainerCore, ContainerView>();
+            factory->registerCoreType<HeadlessLeafCore, MeasuredView>();
+            return factory;
+        }
+
+        std::shared_ptr<ContainerView> createRoot(const std::shared_ptr<ViewCoreFactory> &factory,
+                                                  std::shared_ptr<yoga::Layout> layout = nullptr)
+        {
+            auto root = std::make_shared<ContainerView>(factory);
+            root->geometry = Rect{0, 0, 320, 480};
+            root->setLayout(layout ? std::move(layout) : std::make_shared<yoga::Layout>());
+            return root;
+        }
+
+        std::shared_ptr<ContainerView> createRow(const std::shared_ptr<ViewCoreFactory> &factory)
+        {
+            auto row = std::make_shared<ContainerView>(factory);
+            row->stylesheet = FlexJsonStringify({"size" : {"height" : 10}, "flexShrink" : 0});
+            return row;
+        }
+    }
+
+    TEST(YogaLayout, KeepsChildOrder)
+    {
+        bdn::App()->dispatchQueue()->dispatchSync([=]() {
+            auto factory = headlessViewCoreFactory();
+            auto root = createRoot(factory);
+
+            std::vector<std::shared_ptr<ContainerView>> rows;
+            for (int i = 0; i < 10; i++) {
+                rows.push_back(createRow(factory));
+                root->addChildView(rows.back());
+            }
+
+            // Hidden views leave the yoga tree and come back at their place
+            rows[3]->visible = false;
+            rows[7]->visible = false;
+            rows[3]->visible = true;
+
+            root->viewCore()->startLayout();
+
+            for (int i = 0; i < 10; i++) {
+                if (i != 7) {
+                    int position = i < 7 ? i : i - 1;
+                    EXPECT_EQ(rows[i]->geometry->y, position * 10.0) << "row " << i;
+                }
+            }
+
+            // Re-adding a view appends it
+            root->removeChildView(rows[0]);
+            root->addChildView(rows[0]);
+            root->viewCore()->startLayout();
+            EXPECT_EQ(rows[1]->geometry->y, 0.0);
+            EXPECT_EQ(rows[0]->geometry->y, 80.0);
+        });
+    }
+
+    TEST(YogaLayout, OnlyFlexChangesDirtyLayout)
+    {
+        bdn::App()->dispatchQueue()->dispatchSync([=]() {
+            auto factory = headlessViewCoreFactory();
+            auto root = createRoot(factory);
+            auto rootCore = root->core<HeadlessContainerCore>();
+
+            auto first = createRow(factory);
+            auto second = createRow(factory);
+            root->addChildView(first);
+            root->addChildView(second);
+            root->viewCore()->startLayout();
+
+            int scheduledLayouts = rootCore->scheduledLayouts;
+
+            first->stylesheet =
+                JsonStringify({"flex" : {"size" : {"height" : 10}, "flexShrink" : 0}, "background-color" : "#ff0000"});
+            EXPECT_EQ(rootCore->scheduledLayouts, scheduledLayouts);
+
+            first->stylesheet = FlexJsonStringify({"size" : {"height" : 30}, "flexShrink" : 0});
+            EXPECT_GT(rootCore->scheduledLayouts, scheduledLayouts);
+
+            root->viewCore()->startLayout();
+            EXPECT_EQ(second->geometry->y, 30.0);
+        });
+    }
+
+    TEST(YogaLayout, CachesMeasurements)
+    {
+        bdn::App()->dispatchQueue()->dispatchSync([=]() {
+            auto factory = headlessViewCoreFactory();
+            auto root = createRoot(factory);
+
+            auto leaf = std::make_shared<MeasuredView>(factory);
+            root->addChildView(leaf);
+            root->viewCore()->startLayout();
+
+            auto leafCore = leaf->core<HeadlessLeafCore>();
+            int measurements = leafCore->measurements;
+            EXPECT_GT(measurements, 0);
+            EXPECT_EQ(leaf->geometry->height, 20.0);
+
+            // Dirties the node, but does not change the constraints or the content
+            yoga::ViewData::resetMeasureCacheStatistics();
+            leaf->stylesheet = FlexJsonStringify({"position" : {"top" : 5}});
+            root->viewCore()->startLayout();
+
+            EXPECT_EQ(leafCore->measurements, measurements);
+            EXPECT_GT(yoga::ViewData::measureCacheStatistics().hits, 0u);
+            EXPECT_EQ(leaf->geometry->y, 5.0);
+
+            leafCore->markDirty();
+            root->viewCore()->startLayout();
+
+            EXPECT_GT(leafCore->measurements, measurements);
+            EXPECT_GT(yoga::ViewData::measureCacheStatistics().misses, 0u);
+        });
+    }
+
+    TEST(YogaLayout, LaysOutIndependentRootsTogether)
+    {
+        bdn::App()->dispatchQueue()->dispatchSync([=]() {
+            auto factory = headlessViewCoreFactory();
+            auto layout = std::make_shared<yoga::Layout>();
+
+            std::vector<std::shared_ptr<ContainerView>> roots;
+            std::vector<std::shared_ptr<MeasuredView>> leaves;
+            for (int i = 0; i < 4; i++) {
+                auto root = createRoot(factory, layout);
+                for (int row = 0; row < 100; row++) {
+                    root->addChildView(createRow(factory));
+                }
+                leaves.push_back(std::make_shared<MeasuredView>(factory));
+                root->addChildView(leaves.back());
+                roots.push_back(root);
+            }
+
+            roots[0]->viewCore()->startLayout();
+
+            for (auto &leaf : leaves) {
+                EXPECT_EQ(leaf->geometry->y, 1000.0);
+                EXPECT_EQ(leaf->geometry->height, 20.0);
+            }
+
+            // Laying out a root that is up to date does nothing
+            int measurements = leaves[1]->core<HeadlessLeafCore>()->measurements;
+            leaves[1]->viewCore()->markDirty();
+            roots[2]->viewCore()->startLayout();
+            EXPECT_EQ(leaves[1]->core<HeadlessLeafCore>()->measurements, measurements);
+
+            roots[1]->viewCore()->startLayout();
+            EXPECT_GT(leaves[1]->core<HeadlessLeafCore>()->measurements, measurements);
+        });
+    }
+
+    TEST(YogaLayout, DISABLED_ManyRowsBenchmark)
+    {
+        bdn::App()->dispatchQueue()->dispatchSync([=]() {
+            const int numberOfRows = 5000;
+
+            auto factory = headlessViewCoreFactory();
+            auto root = createRoot(factory);
+
+            std::vector<std::shared_ptr<ContainerView>> rows;
+            rows.reserve(numberOfRows);
+            for (int i = 0; i < numberOfRows; i++) {
+                rows.push_back(createRow(factory));
+            }
+
+            StopWatch setupWatch;
+            for (auto &row : rows) {
+                root->addChildView(row);
+            }
+            auto setupTime = setupWatch.elapsed();
+
+            StopWatch layoutWatch;
+            root->viewCore()->startLayout();
+            auto layoutTime = layoutWatch.elapsed();
+
+            EXPECT_EQ(rows.back()->geometry->y, (numberOfRows - 1) * 10.0);
+
+            logstream() << numberOfRows << " rows: layout setup "
+                        << std::chrono::duration_cast<std::chrono::milliseconds>(setupTime).count()
+                        << "ms, first layout "
+                        << std::chrono::duration_cast<std::chrono::milliseconds>(layoutTime).count() << "ms";
+        });
+    }
+
+    TEST(YogaLayout, DISABLED_TeardownBenchmark)
+    {
+        bdn::App()->dispatchQueue()->dispatchSync([=]() {
+            const int numberOfRows = 5000;
+
+            auto factory = headlessViewCoreFactory();
+            auto root = createRoot(factory);
+
+            for (int i = 0; i < numberOfRows; i++) {
+                root->addChildView(createRow(factory));
+            }
+            root->viewCore()->startLayout();
+
+            StopWatch watch;
+            root->removeAllChildViews();
+            auto teardownTime = watch.elapsed();
+
+            EXPECT_TRUE(root->childViews().empty());
+
+            logstream() << numberOfRows << " rows: teardown "
+                        << std::chrono::duration_cast<std::chrono::milliseconds>(teardownTime).count() << "ms";
+        });
+    }
+}